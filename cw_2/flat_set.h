@@ -0,0 +1,220 @@
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A set kept sorted in one contiguous container. Lookups are binary searches over
+// adjacent elements and iteration is a linear scan; there is no allocation per element.
+// Inserting or erasing in the middle moves the elements behind it, and any insertion may
+// move all of them: use std::set when references to elements must stay valid.
+//
+// With a transparent Compare (one that defines is_transparent) find(), contains(),
+// count(), lower_bound(), upper_bound(), equal_range() and erase() accept anything the
+// comparator can compare with a Key, e.g. an id instead of a whole object.
+template <typename Key, typename Compare = std::less<Key>, typename Container = std::vector<Key>>
+class FlatSet {
+private:
+    static constexpr bool Transparent = requires { typename Compare::is_transparent; };
+
+    // what lookups accept: any type the comparator takes when it is transparent, otherwise
+    // anything convertible to Key (converted once per call, like std::set does)
+    template <typename K>
+    static constexpr bool LookupKey = Transparent || std::is_convertible_v<const K&, Key>;
+
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using container_type = Container;
+    using size_type = typename Container::size_type;
+    using difference_type = typename Container::difference_type;
+    using reference = const Key&;
+    using const_reference = const Key&;
+    // elements are read-only: changing one in place could break the order
+    using iterator = typename Container::const_iterator;
+    using const_iterator = iterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = reverse_iterator;
+
+    FlatSet() = default;
+
+    explicit FlatSet(const Compare& compare) : _compare(compare) {}
+
+    // takes over the elements of values: one sort, no per-element insertion
+    explicit FlatSet(Container values, const Compare& compare = Compare())
+        : _values(std::move(values)), _compare(compare) {
+        mergeTail(0);
+    }
+
+    template <std::input_iterator InputIt>
+    FlatSet(InputIt first, InputIt last, const Compare& compare = Compare()) : _compare(compare) {
+        insert(first, last);
+    }
+
+    FlatSet(std::initializer_list<Key> values, const Compare& compare = Compare()) : _compare(compare) {
+        insert(values.begin(), values.end());
+    }
+
+    iterator begin() const noexcept { return _values.begin(); }
+    iterator end() const noexcept { return _values.end(); }
+    iterator cbegin() const noexcept { return _values.begin(); }
+    iterator cend() const noexcept { return _values.end(); }
+    reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
+
+    bool empty() const noexcept { return _values.empty(); }
+    size_type size() const noexcept { return _values.size(); }
+    size_type capacity() const noexcept { return _values.capacity(); }
+    void reserve(size_type count) { _values.reserve(count); }
+    void shrink_to_fit() { _values.shrink_to_fit(); }
+    void clear() noexcept { _values.clear(); }
+
+    key_compare key_comp() const { return _compare; }
+    value_compare value_comp() const { return _compare; }
+
+    // the sorted elements; the set is left empty
+    Container extract() && { return std::move(_values); }
+
+    std::pair<iterator, bool> insert(const Key& value) { return insertUnique(value); }
+    std::pair<iterator, bool> insert(Key&& value) { return insertUnique(std::move(value)); }
+
+    // constructs the element from args, then moves it into place if its key is new
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        return insertUnique(Key(std::forward<Args>(args)...));
+    }
+
+    // Bulk insertion: the new elements are appended, sorted together and merged with the
+    // existing ones in one pass. Of equivalent elements the one already in the set, then
+    // the first in the range, is kept.
+    template <std::input_iterator InputIt>
+    void insert(InputIt first, InputIt last) {
+        size_type oldSize = _values.size();
+        _values.insert(_values.end(), first, last);
+        mergeTail(oldSize);
+    }
+
+    // like insert(first, last); the elements are moved when range is an rvalue container
+    template <std::ranges::input_range R>
+    void insert_range(R&& range) {
+        size_type oldSize = _values.size();
+        if constexpr (std::is_same_v<std::remove_cvref_t<R>, Container> && !std::is_lvalue_reference_v<R>) {
+            if (oldSize == 0) {
+                _values = std::move(range);
+            } else {
+                _values.insert(_values.end(), std::make_move_iterator(range.begin()), std::make_move_iterator(range.end()));
+            }
+        } else {
+            for (auto&& value : range) {
+                _values.emplace_back(std::forward<decltype(value)>(value));
+            }
+        }
+        mergeTail(oldSize);
+    }
+
+    iterator erase(const_iterator position) { return _values.erase(position); }
+    iterator erase(const_iterator first, const_iterator last) { return _values.erase(first, last); }
+
+    template <typename K = Key>
+        requires LookupKey<K>
+    size_type erase(const K& key) {
+        auto position = find(key);
+        if (position == end()) return 0;
+        _values.erase(position);
+        return 1;
+    }
+
+    template <typename K = Key>
+        requires LookupKey<K>
+    iterator lower_bound(const K& key) const {
+        return std::lower_bound(_values.begin(), _values.end(), asLookupKey(key), _compare);
+    }
+
+    template <typename K = Key>
+        requires LookupKey<K>
+    iterator upper_bound(const K& key) const {
+        return std::upper_bound(_values.begin(), _values.end(), asLookupKey(key), _compare);
+    }
+
+    template <typename K = Key>
+        requires LookupKey<K>
+    std::pair<iterator, iterator> equal_range(const K& key) const {
+        decltype(auto) lookup = asLookupKey(key);
+        iterator first = std::lower_bound(_values.begin(), _values.end(), lookup, _compare);
+        return { first, first != end() && !_compare(lookup, *first) ? std::next(first) : first };
+    }
+
+    template <typename K = Key>
+        requires LookupKey<K>
+    iterator find(const K& key) const {
+        decltype(auto) lookup = asLookupKey(key);
+        iterator position = std::lower_bound(_values.begin(), _values.end(), lookup, _compare);
+        return position != end() && !_compare(lookup, *position) ? position : end();
+    }
+
+    template <typename K = Key>
+        requires LookupKey<K>
+    bool contains(const K& key) const {
+        return find(key) != end();
+    }
+
+    template <typename K = Key>
+        requires LookupKey<K>
+    size_type count(const K& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    friend bool operator==(const FlatSet& a, const FlatSet& b) { return a._values == b._values; }
+
+private:
+    Container _values;
+    [[no_unique_address]] Compare _compare;
+
+    template <typename K>
+    static decltype(auto) asLookupKey(const K& key) {
+        if constexpr (Transparent || std::is_same_v<K, Key>) {
+            return (key);
+        } else {
+            return Key(key);
+        }
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> insertUnique(V&& value) {
+        // appending in ascending order needs no search
+        if (_values.empty() || _compare(_values.back(), value)) {
+            _values.push_back(std::forward<V>(value));
+            return { std::prev(_values.end()), true };
+        }
+        auto position = std::lower_bound(_values.begin(), _values.end(), value, _compare);
+        if (!_compare(value, *position)) {
+            return { position, false };
+        }
+        return { _values.insert(position, std::forward<V>(value)), true };
+    }
+
+    // sorts the elements from oldSize on and merges them into the sorted ones before
+    void mergeTail(size_type oldSize) {
+        auto equivalent = [this](const Key& a, const Key& b) { return !_compare(a, b); };  // a <= b on sorted input
+        auto middle = _values.begin() + static_cast<difference_type>(oldSize);
+        std::stable_sort(middle, _values.end(), _compare);
+        _values.erase(std::unique(middle, _values.end(), equivalent), _values.end());
+
+        middle = _values.begin() + static_cast<difference_type>(oldSize);
+        if (oldSize == 0 || middle == _values.end() || _compare(*std::prev(middle), *middle)) {
+            return;  // already in order: everything new is after everything old
+        }
+        std::inplace_merge(_values.begin(), middle, _values.end(), _compare);
+        _values.erase(std::unique(_values.begin(), _values.end(), equivalent), _values.end());
+    }
+};
+
+#endif // FLAT_SET_H
@@ -0,0 +1,240 @@
+#ifndef INSTRUMENTED_H
+#define INSTRUMENTED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+// Counts of the special member calls and heap allocations of one type. Counters are per
+// thread: a thread sees only what it did itself, so a check in one thread is not disturbed
+// by others, and counting is a plain increment.
+struct LifetimeCounts {
+    std::uint64_t constructions = 0;      // other than copies and moves
+    std::uint64_t copyConstructions = 0;
+    std::uint64_t copyAssignments = 0;
+    std::uint64_t moveConstructions = 0;
+    std::uint64_t moveAssignments = 0;
+    std::uint64_t destructions = 0;
+    std::uint64_t allocations = 0;        // through CountingAllocator<..., T>
+    std::uint64_t allocatedBytes = 0;
+    std::uint64_t freedBytes = 0;
+
+    std::uint64_t copies() const { return copyConstructions + copyAssignments; }
+    std::uint64_t moves() const { return moveConstructions + moveAssignments; }
+    // objects constructed and not yet destroyed (negative when other threads constructed them)
+    std::int64_t alive() const {
+        return static_cast<std::int64_t>(constructions + copyConstructions + moveConstructions) -
+               static_cast<std::int64_t>(destructions);
+    }
+    std::int64_t liveBytes() const {
+        return static_cast<std::int64_t>(allocatedBytes) - static_cast<std::int64_t>(freedBytes);
+    }
+
+    friend LifetimeCounts operator-(LifetimeCounts a, const LifetimeCounts& b) {
+        a.constructions -= b.constructions;
+        a.copyConstructions -= b.copyConstructions;
+        a.copyAssignments -= b.copyAssignments;
+        a.moveConstructions -= b.moveConstructions;
+        a.moveAssignments -= b.moveAssignments;
+        a.destructions -= b.destructions;
+        a.allocations -= b.allocations;
+        a.allocatedBytes -= b.allocatedBytes;
+        a.freedBytes -= b.freedBytes;
+        return a;
+    }
+
+    // one line, e.g. "0 constructions, 1 copy, 0 moves, 0 destructions, 1 allocation (12 bytes)"
+    friend std::ostream& operator<<(std::ostream& out, const LifetimeCounts& counts) {
+        auto count = [&out](std::uint64_t n, const char* one, const char* many) {
+            out << n << " " << (n == 1 ? one : many);
+        };
+        count(counts.constructions, "construction", "constructions");
+        out << ", ";
+        count(counts.copies(), "copy", "copies");
+        out << ", ";
+        count(counts.moves(), "move", "moves");
+        out << ", ";
+        count(counts.destructions, "destruction", "destructions");
+        out << ", ";
+        count(counts.allocations, "allocation", "allocations");
+        return out << " (" << counts.allocatedBytes << " bytes)";
+    }
+};
+
+namespace instrumentation_detail {
+    // readable name of T: typeid names are mangled with gcc and clang ("7MyClass")
+    template <typename T>
+    const char* typeName() {
+        static const std::string name = [] {
+            const char* raw = typeid(T).name();
+#ifdef __GNUG__
+            int status = 0;
+            std::unique_ptr<char, void (*)(void*)> demangled(abi::__cxa_demangle(raw, nullptr, nullptr, &status),
+                                                             std::free);
+            if (status == 0 && demangled) return std::string(demangled.get());
+#endif
+            return std::string(raw);
+        }();
+        return name.c_str();
+    }
+
+    struct Registration {
+        const char* name;
+        const LifetimeCounts* counts;
+    };
+
+    // the instrumented types this thread has used, in order of first use
+    inline std::vector<Registration>& threadRegistry() {
+        thread_local std::vector<Registration> registry;
+        return registry;
+    }
+
+    template <typename T>
+    struct TypeCounts {
+        LifetimeCounts counts;
+
+        TypeCounts() { threadRegistry().push_back({ typeName<T>(), &counts }); }
+    };
+
+    template <typename T>
+    LifetimeCounts& countsOf() {
+        thread_local TypeCounts<T> typeCounts;
+        return typeCounts.counts;
+    }
+}
+
+// the counts of T in the calling thread
+template <typename T>
+const LifetimeCounts& lifetimeCounts() {
+    return instrumentation_detail::countsOf<T>();
+}
+
+// Base class that counts the special member calls of T:
+//
+//     class Widget : public Instrumented<Widget> { ... };
+//
+// User-declared copy and move operations of T must call the matching ones of the base,
+// e.g. `Widget(const Widget& other) : Instrumented(other), ...`.
+template <typename T>
+class Instrumented {
+protected:
+    Instrumented() { ++instrumentation_detail::countsOf<T>().constructions; }
+    Instrumented(const Instrumented&) { ++instrumentation_detail::countsOf<T>().copyConstructions; }
+    Instrumented(Instrumented&&) noexcept { ++instrumentation_detail::countsOf<T>().moveConstructions; }
+
+    Instrumented& operator=(const Instrumented&) {
+        ++instrumentation_detail::countsOf<T>().copyAssignments;
+        return *this;
+    }
+
+    Instrumented& operator=(Instrumented&&) noexcept {
+        ++instrumentation_detail::countsOf<T>().moveAssignments;
+        return *this;
+    }
+
+    ~Instrumented() { ++instrumentation_detail::countsOf<T>().destructions; }
+};
+
+// A std::allocator that charges its allocations to Owner, for the members of Owner that
+// hold heap memory: `std::vector<int, CountingAllocator<int, Widget>> _data;`. A deep copy
+// of a Widget then shows up as allocations, not just as a copy.
+template <typename U, typename Owner>
+struct CountingAllocator {
+    using value_type = U;
+
+    template <typename V>
+    struct rebind {
+        using other = CountingAllocator<V, Owner>;
+    };
+
+    CountingAllocator() = default;
+
+    template <typename V>
+    CountingAllocator(const CountingAllocator<V, Owner>&) noexcept {}
+
+    U* allocate(std::size_t count) {
+        U* values = std::allocator<U>().allocate(count);
+        LifetimeCounts& counts = instrumentation_detail::countsOf<Owner>();
+        ++counts.allocations;
+        counts.allocatedBytes += count * sizeof(U);
+        return values;
+    }
+
+    void deallocate(U* values, std::size_t count) noexcept {
+        instrumentation_detail::countsOf<Owner>().freedBytes += count * sizeof(U);
+        std::allocator<U>().deallocate(values, count);
+    }
+
+    template <typename V>
+    bool operator==(const CountingAllocator<V, Owner>&) const noexcept { return true; }
+};
+
+// The counts of T in the calling thread since construction
+template <typename T>
+class LifetimeDelta {
+public:
+    LifetimeDelta() : _start(lifetimeCounts<T>()) {}
+
+    LifetimeCounts since() const { return lifetimeCounts<T>() - _start; }
+    void restart() { _start = lifetimeCounts<T>(); }
+
+private:
+    LifetimeCounts _start;
+};
+
+// A check for tests and hot paths: aborts, naming the scope, if the calling thread copies
+// a T before the guard is destroyed.
+//
+//     {
+//         ExpectNoCopies<MyClass> guard("insert by move");
+//         set.insert(std::move(object));
+//     }
+template <typename T>
+class ExpectNoCopies {
+public:
+    explicit ExpectNoCopies(const char* scope) : _scope(scope) {}
+
+    ExpectNoCopies(const ExpectNoCopies&) = delete;
+    ExpectNoCopies& operator=(const ExpectNoCopies&) = delete;
+
+    ~ExpectNoCopies() {
+        LifetimeCounts counts = _delta.since();
+        if (counts.copies() != 0) {
+            std::cerr << _scope << ": unexpected copies of " << instrumentation_detail::typeName<T>() << " ("
+                      << counts << ")" << std::endl;
+            std::abort();
+        }
+    }
+
+    std::uint64_t copies() const { return _delta.since().copies(); }
+
+private:
+    const char* _scope;
+    LifetimeDelta<T> _delta;
+};
+
+// a table of the counts of every instrumented type the calling thread has used
+inline void printLifetimeReport(std::ostream& out) {
+    out << "Lifetime counts (this thread):\n";
+    out << "  type                constructed   copied    moved  destroyed  alive  allocations  heap bytes  live bytes\n";
+    for (const instrumentation_detail::Registration& type : instrumentation_detail::threadRegistry()) {
+        const LifetimeCounts& counts = *type.counts;
+        out << "  " << std::left << std::setw(20) << type.name << std::right << std::setw(11) << counts.constructions
+            << std::setw(9) << counts.copies() << std::setw(9) << counts.moves() << std::setw(11)
+            << counts.destructions << std::setw(7) << counts.alive() << std::setw(13) << counts.allocations
+            << std::setw(12) << counts.allocatedBytes << std::setw(12) << counts.liveBytes() << "\n";
+    }
+}
+
+#endif // INSTRUMENTED_H
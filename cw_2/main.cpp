@@ -1,49 +1,54 @@
-
 #include <set>
 #include <vector>
 #include <string>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <random>
+
+#include "flat_set.h"
+#include "instrumented.h"
+
+/* counts its constructions, copies, moves and the heap memory of its data (see instrumented.h) */
+class MyClass : public Instrumented<MyClass> {
+public:
+    using Data = std::vector<int, CountingAllocator<int, MyClass>>;
 
-class MyClass {
 private:
     int _id;
     std::string _name;
-    std::vector<int> _data;
+    Data _data;
 
 public:
-
     MyClass()  /* default constructor */
         : _id(0)
         , _name("Default")
         , _data({})
-    {
-        std::cout << "Default constructor called\n";
-    }
+    {}
 
-    MyClass(int id, std::string name, std::vector<int> data)
+    MyClass(int id, std::string name, Data data)
         : _id(id)
         , _name(std::move(name))
         , _data(std::move(data))
-    {
-        std::cout << "Parameterized constructor called\n";
-    }
+    {}
 
     
     MyClass(const MyClass& other)  /* copy constructor */
-        : _id(other._id)
+        : Instrumented(other)
+        , _id(other._id)
         , _name(other._name)
         , _data(other._data)
-    {
-        std::cout << "Copy constructor called\n";
-    }
+    {}
 
     
     MyClass(MyClass&& other) noexcept  /* move constructor */
-        : _id(other._id)
+        : Instrumented(std::move(other))
+        , _id(other._id)
         , _name(std::move(other._name))
         , _data(std::move(other._data))
     {
-        std::cout << "Move constructor called\n";
         other._id = 0;
         other._name = "Moved";
     }
@@ -52,10 +57,10 @@ public:
     MyClass& operator=(const MyClass& other)  /* copy assignment operator */
     {
         if (this != &other) {
+            Instrumented::operator=(other);
             _id = other._id;
             _name = other._name;
             _data = other._data;
-            std::cout << "Copy assignment operator called\n";
         }
         return *this;
     }
@@ -64,19 +69,17 @@ public:
     MyClass& operator=(MyClass&& other) noexcept  /* move assignment operator */
     {
         if (this != &other) {
+            Instrumented::operator=(std::move(other));
             _id = other._id;
             _name = std::move(other._name);
             _data = std::move(other._data);
             other._id = 0;
             other._name = "Moved";
-            std::cout << "Move assignment operator called\n";
         }
         return *this;
     }
 
-    ~MyClass() {
-        std::cout << "Destructor called for id: " << _id << "\n";
-    }
+    ~MyClass() = default;
 
     
     void display() const  /* helper function to display the contents of the object */
@@ -87,34 +90,173 @@ public:
         std::cout << "]\n";
     }
 
+    int id() const { return _id; }
+
     bool operator<(const MyClass& other) const  /* comparison operator for std::set */
     {
         return _id < other._id;  /* comparing by ID only */
     }
 };
 
-int main()
+/* orders MyClass objects by id; transparent, so a set can also be searched by a plain id */
+struct MyClassById {
+    using is_transparent = void;
+
+    bool operator()(const MyClass& a, const MyClass& b) const { return a.id() < b.id(); }
+    bool operator()(const MyClass& a, int id) const { return a.id() < id; }
+    bool operator()(int id, const MyClass& b) const { return id < b.id(); }
+};
+
+/* sorted contiguous set: the default for MyClass collections */
+using MyClassSet = FlatSet<MyClass, MyClassById>;
+/* node-based set: for code that keeps references to elements while inserting or erasing */
+using MyClassNodeSet = std::set<MyClass, MyClassById>;
+
+/* best time of f() over runs, in milliseconds */
+template <typename F>
+double bestTime(int runs, F f) {
+    double best = 1e300;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+std::vector<MyClass> makeObjects(int count, std::mt19937& random) {
+    std::vector<MyClass> objects;
+    objects.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        objects.emplace_back(2 * i, "Object" + std::to_string(i), MyClass::Data{ i, i + 1, i + 2 });
+    }
+    std::shuffle(objects.begin(), objects.end(), random);
+    return objects;
+}
+
+/* building, lookups by id (half of them misses) and a full scan, for each kind of set */
+bool runBenchmarks(int count) {
+    std::mt19937 random(42);
+    std::vector<int> ids(count);
+    for (int& id : ids) id = static_cast<int>(random() % (2 * static_cast<unsigned>(count)));
+    std::cout << count << " objects, " << count << " lookups (best of 3, ms):\n";
+    std::cout << "  set                        build    lookup      scan\n";
+
+    bool consistent = true;
+    std::int64_t expectedFound = -1;
+    const std::int64_t expectedIdSum = static_cast<std::int64_t>(count) * (count - 1);
+    auto row = [&](const char* name, double build, double lookup, double scan, std::int64_t found, std::int64_t idSum) {
+        std::cout << "  " << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << build << std::setw(10) << lookup << std::setw(10) << scan << "\n";
+        if (expectedFound < 0) expectedFound = found;
+        consistent = consistent && found == expectedFound && idSum == expectedIdSum;
+    };
+    std::int64_t found = 0;
+    std::int64_t idSum = 0;
+
+    {
+        // the original: MyClass::operator<, so a lookup needs a MyClass to compare with
+        std::set<MyClass> set;
+        double build = bestTime(3, [&] {
+            std::vector<MyClass> objects = makeObjects(count, random);
+            set.clear();
+            for (MyClass& object : objects) set.insert(std::move(object));
+        });
+        double lookup = bestTime(3, [&] {
+            found = 0;
+            for (int id : ids) found += set.count(MyClass(id, "", {}));
+        });
+        double scan = bestTime(3, [&] {
+            idSum = 0;
+            for (const MyClass& object : set) idSum += object.id();
+        });
+        row("std::set<MyClass>", build, lookup, scan, found, idSum);
+    }
+    {
+        MyClassNodeSet set;
+        double build = bestTime(3, [&] {
+            std::vector<MyClass> objects = makeObjects(count, random);
+            set.clear();
+            for (MyClass& object : objects) set.insert(std::move(object));
+        });
+        double lookup = bestTime(3, [&] {
+            found = 0;
+            for (int id : ids) found += set.count(id);
+        });
+        double scan = bestTime(3, [&] {
+            idSum = 0;
+            for (const MyClass& object : set) idSum += object.id();
+        });
+        row("std::set, by id", build, lookup, scan, found, idSum);
+    }
+    {
+        MyClassSet set;
+        double build = bestTime(3, [&] {
+            std::vector<MyClass> objects = makeObjects(count, random);
+            set.clear();
+            ExpectNoCopies<MyClass> guard("FlatSet build");
+            set.insert_range(std::move(objects));  // takes over the vector: one sort, no copies
+        });
+        double lookup = bestTime(3, [&] {
+            found = 0;
+            for (int id : ids) found += set.count(id);
+        });
+        double scan = bestTime(3, [&] {
+            idSum = 0;
+            for (const MyClass& object : set) idSum += object.id();
+        });
+        row("FlatSet, by id", build, lookup, scan, found, idSum);
+    }
+    return consistent;
+}
+
+/* cw1 bench [count]: compares the sets on count objects (default 10^6) */
+int main(int argc, char* argv[])
 {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        int count = argc > 2 ? std::max(1, std::stoi(argv[2])) : 1'000'000;
+        return runBenchmarks(count) ? 0 : 1;
+    }
+
+    // what each step costs, from the counters of MyClass
+    LifetimeDelta<MyClass> delta;
+    auto step = [&delta](const char* what) {
+        std::cout << "--- " << what << ": " << delta.since() << "\n";
+        delta.restart();
+    };
+
     std::cout << "start\n";
     MyClass obj1(1, "Object1", { 1, 2, 3 });
-    std::cout << "--- obj1 created\n";
+    step("obj1 created");
 
     MyClass obj2(2, "Object2", { 4, 5, 6 });
-    std::cout << "--- obj2 created\n";
+    step("obj2 created");
 
-    std::set<MyClass> mySet;
+    MyClassSet mySet;
+    mySet.reserve(3);  /* no reallocation (and no moves of the stored objects) while inserting */
 
     mySet.insert(obj1);  /* insertion with copying */
-    std::cout << "--- obj1 inserted into the set\n";
+    step("obj1 inserted into the set");
 
-    mySet.insert(std::move(obj2));  /* insertion with move */
-    std::cout << "--- obj2 moved into the set\n";
+    {
+        ExpectNoCopies<MyClass> guard("inserting by move");
+        mySet.insert(std::move(obj2));  /* insertion with move */
+        mySet.emplace(3, "Object3", MyClass::Data{ 7, 8, 9 });  /* constructed from the arguments, then moved in */
+    }
+    step("obj2 moved and obj3 emplaced into the set");
 
     MyClass obj3 = obj1;  /* make a copy of an object */
-    std::cout << "--- obj1 copyed to obj3\n";
+    step("obj1 copyed to obj3");
 
     MyClass obj4 = std::move(obj3);  /* move an object */
-    std::cout << "--- obj3 moved to obj4\n";
+    step("obj3 moved to obj4");
+
+    // lookup by id: no MyClass has to be constructed for the comparison
+    std::cout << "\nObject with id 2:\n";
+    if (auto it = mySet.find(2); it != mySet.end()) {
+        it->display();
+    }
 
     // print all objects stored in the set
     std::cout << "\nContents of the set:\n";
@@ -122,5 +264,7 @@ int main()
         obj.display();
     }
 
+    std::cout << "\n";
+    printLifetimeReport(std::cout);
     return 0;
 }
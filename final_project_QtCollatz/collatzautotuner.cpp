@@ -0,0 +1,161 @@
+#include "collatzautotuner.h"
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QSysInfo>
+#include <QThread>
+#include <QList>
+
+// Calibration scans the smallest range the UI accepts, so every candidate
+// takes a fraction of a second and still runs the same code as a real search.
+static constexpr quint64 kCalibrationLimit = 1000000;
+
+// Settings keys of the saved profile.
+static const char *kKeyFingerprint   = "fingerprint";
+static const char *kKeyKernel        = "kernel";
+static const char *kKeyThreads       = "threads";
+static const char *kKeyBlockSize     = "blockSize";
+static const char *kKeyMemoSize      = "memoSize";
+static const char *kKeyCalibrationMs = "calibrationMs";
+
+static QSettings profileSettings() {
+    return QSettings(QSettings::IniFormat, QSettings::UserScope,
+                     QStringLiteral("CollatzSearch"), QStringLiteral("autotune"));
+}
+
+// Wall-clock time of a single calibration scan in nanoseconds.
+static qint64 measure(const CollatzOptions &options, std::atomic_bool &stopFlag) {
+    QElapsedTimer timer;
+    timer.start();
+    CollatzCalculator::calculate(kCalibrationLimit, options, stopFlag);
+    return timer.nsecsElapsed();
+}
+
+// Tries every candidate and keeps the fastest in 'best'.
+// Candidates are built from 'best' by the 'apply' callback, so each search step
+// only varies one parameter while the ones chosen earlier stay fixed.
+template <typename Value, typename Apply>
+static void searchStep(const QList<Value> &values, Apply apply, CollatzOptions &best,
+                       qint64 &bestTime, std::atomic_bool &stopFlag) {
+    CollatzOptions start = best;
+    for (const Value &value : values) {
+        if (stopFlag.load()) {
+            return;
+        }
+        CollatzOptions candidate = start;
+        apply(candidate, value);
+        qint64 time = measure(candidate, stopFlag);
+        if (!stopFlag.load() && time < bestTime) {
+            bestTime = time;
+            best = candidate;
+        }
+    }
+}
+
+QString CollatzAutotuner::hardwareFingerprint() {
+    return QString("%1|%2|%3 %4|%5")
+        .arg(QSysInfo::currentCpuArchitecture())
+        .arg(QThread::idealThreadCount())
+        .arg(QSysInfo::kernelType(), QSysInfo::kernelVersion())
+        .arg(QString::fromLatin1(QSysInfo::machineUniqueId().toHex()));
+}
+
+std::optional<CollatzProfile> CollatzAutotuner::loadProfile() {
+    QSettings settings = profileSettings();
+    if (settings.value(kKeyFingerprint).toString() != hardwareFingerprint()) {
+        return std::nullopt;  // No profile yet, or the machine has changed.
+    }
+
+    CollatzProfile profile;
+    profile.fingerprint = settings.value(kKeyFingerprint).toString();
+    profile.calibrationMs = settings.value(kKeyCalibrationMs).toLongLong();
+    profile.options.numThreads = settings.value(kKeyThreads, 1).toInt();
+    profile.options.blockSize = settings.value(kKeyBlockSize, 0).toULongLong();
+    profile.options.memoSize = settings.value(kKeyMemoSize, 0).toULongLong();
+
+    QString kernel = settings.value(kKeyKernel).toString();
+    bool known = false;
+    for (CollatzKernel k : { CollatzKernel::Plain, CollatzKernel::Shortcut, CollatzKernel::Memo, CollatzKernel::PackedMemo }) {
+        if (CollatzCalculator::kernelName(k) == kernel) {
+            profile.options.kernel = k;
+            known = true;
+        }
+    }
+    if (!known || profile.options.numThreads < 1) {
+        return std::nullopt;  // Written by an incompatible version.
+    }
+    return profile;
+}
+
+void CollatzAutotuner::saveProfile(const CollatzProfile &profile) {
+    QSettings settings = profileSettings();
+    settings.setValue(kKeyFingerprint, profile.fingerprint);
+    settings.setValue(kKeyKernel, CollatzCalculator::kernelName(profile.options.kernel));
+    settings.setValue(kKeyThreads, profile.options.numThreads);
+    settings.setValue(kKeyBlockSize, profile.options.blockSize);
+    settings.setValue(kKeyMemoSize, profile.options.memoSize);
+    settings.setValue(kKeyCalibrationMs, profile.calibrationMs);
+    settings.sync();
+}
+
+CollatzProfile CollatzAutotuner::calibrate(std::atomic_bool &stopFlag) {
+    QElapsedTimer timer;
+    timer.start();
+
+    // Warm-up run with the reference options: brings the code and the thread pool
+    // into a steady state, and gives the baseline every candidate has to beat.
+    CollatzOptions best;
+    measure(best, stopFlag);
+    qint64 bestTime = measure(best, stopFlag);
+
+    // 1. Kernel, measured on a single thread to keep scheduling noise out.
+    // The packed table holds 3.5 times more values in the same cache footprint.
+    searchStep(QList<CollatzKernel> { CollatzKernel::Shortcut, CollatzKernel::Memo, CollatzKernel::PackedMemo },
+               [](CollatzOptions &o, CollatzKernel k) {
+                   o.kernel = k;
+                   o.memoSize = k == CollatzKernel::Memo       ? (1ULL << 16)
+                              : k == CollatzKernel::PackedMemo ? (1ULL << 18) : 0;
+               },
+               best, bestTime, stopFlag);
+
+    // 2. Memo size: bigger tables save more steps but stop fitting in cache.
+    if (best.kernel == CollatzKernel::Memo) {
+        searchStep(QList<quint64> { 1ULL << 12, 1ULL << 14, 1ULL << 18, 1ULL << 20 },
+                   [](CollatzOptions &o, quint64 size) { o.memoSize = size; },
+                   best, bestTime, stopFlag);
+    } else if (best.kernel == CollatzKernel::PackedMemo) {
+        searchStep(QList<quint64> { 1ULL << 14, 1ULL << 16, 1ULL << 20, 1ULL << 22 },
+                   [](CollatzOptions &o, quint64 size) { o.memoSize = size; },
+                   best, bestTime, stopFlag);
+    }
+
+    // 3. Threads and scheduling, measured as a grid because the two interact:
+    // dynamic blocks only pay off when there are several threads to balance,
+    // and more threads are not always faster (see README).
+    QList<int> threadCounts;
+    int maxThreads = QThread::idealThreadCount();
+    for (int n = 1; n < maxThreads; n *= 2) {
+        threadCounts.append(n);
+    }
+    threadCounts.append(maxThreads);
+    QList<CollatzOptions> schedules;
+    for (quint64 blockSize : { 0ULL, 1ULL << 10, 1ULL << 14 }) {
+        for (int threads : threadCounts) {
+            CollatzOptions schedule;
+            schedule.numThreads = threads;
+            schedule.blockSize = blockSize;
+            schedules.append(schedule);
+        }
+    }
+    searchStep(schedules,
+               [](CollatzOptions &o, const CollatzOptions &schedule) {
+                   o.numThreads = schedule.numThreads;
+                   o.blockSize = schedule.blockSize;
+               },
+               best, bestTime, stopFlag);
+
+    CollatzProfile profile;
+    profile.options = best;
+    profile.fingerprint = hardwareFingerprint();
+    profile.calibrationMs = timer.elapsed();
+    return profile;
+}
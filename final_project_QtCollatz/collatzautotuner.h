@@ -0,0 +1,35 @@
+#ifndef COLLATZAUTOTUNER_H
+#define COLLATZAUTOTUNER_H
+
+#include <QtGlobal>
+#include <QString>
+#include <atomic>
+#include <optional>
+#include "collatzcalculator.h"
+
+// Calibration result that is stored between application runs.
+struct CollatzProfile {
+    CollatzOptions options;  // Fastest combination found on this machine.
+    QString fingerprint;     // Hardware fingerprint the profile was measured on.
+    qint64 calibrationMs;    // Time spent on calibration.
+};
+
+class CollatzAutotuner {
+public:
+    // Short description of the hardware the timings depend on
+    // (CPU architecture, logical core count, OS kernel, machine id).
+    static QString hardwareFingerprint();
+
+    // Loads the saved profile. Returns nothing if there is no profile yet
+    // or if it was measured on different hardware.
+    static std::optional<CollatzProfile> loadProfile();
+
+    // Saves the profile to the per-user config file.
+    static void saveProfile(const CollatzProfile &profile);
+
+    // Runs short calibration scans and returns the fastest options for this machine.
+    // Returns the best options found so far if stopFlag is set during calibration.
+    static CollatzProfile calibrate(std::atomic_bool &stopFlag);
+};
+
+#endif // COLLATZAUTOTUNER_H
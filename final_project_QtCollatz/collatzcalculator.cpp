@@ -1,37 +1,39 @@
 #include "collatzcalculator.h"
+#include "collatzmap.h"
+#include "collatzpackedmemo.h"
+#include "collatztrace.h"
 #include <QtConcurrent>
 #include <QFuture>
 #include <QElapsedTimer>
 #include <QList>
-#include <limits>
+#include <QtAlgorithms>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Engine instance for the 3n+1 rule. Every 64-bit start value is known to converge,
+// so the loop runs without cycle detection and step bound.
+using Engine3x1 = CollatzEngine<Collatz3x1, false>;
 
 // Internal helper function that computes the Collatz sequence starting from 'start'.
 // If 'seq' is not nullptr, the computed numbers are appended to it.
 // Returns the length of the sequence.
 static quint64 computeCollatz(quint64 start, QString *seq = nullptr) {
-    quint64 length = 1;
-    quint64 n = start;
+    Orbit<quint64> orbit;
     if (seq) {
-        seq->append(QString::number(n));
-    }
-    while (n != 1) {
-        if ((n & 1ULL) == 0ULL) {
-            n >>= 1; // Efficient division by 2.
-        } else {
-            // Check for overflow before computing 3*n + 1.
-            if (n > (std::numeric_limits<quint64>::max() - 1) / 3) {
-                throw std::overflow_error("64-bit integer overflow during calculation");
+        orbit = Engine3x1::run(start, ~0ULL, [seq](quint64 n) {
+            if (!seq->isEmpty()) {
+                seq->append(" → ");
             }
-            n = 3 * n + 1;
-        }
-        length++;
-        if (seq) {
-            seq->append(" → ");
             seq->append(QString::number(n));
-        }
+        });
+    } else {
+        orbit = Engine3x1::run(start);
+    }
+    if (orbit.status == OrbitStatus::Overflow) {
+        throw std::overflow_error("64-bit integer overflow during calculation");
     }
-    return length;
+    return orbit.length;
 }
 
 // Wrapper function to compute length without capturing the sequence.
@@ -39,57 +41,281 @@ static quint64 collatzLength(quint64 start) {
     return computeCollatz(start, nullptr);
 }
 
+// Computes the same length as collatzLength(), but every run of trailing zero bits
+// is removed with a single shift: 3n + 1 of an odd n is always even, so each odd step
+// is followed by at least one halving.
+// Iterates only while n >= floor, so the caller can finish the chain from a table.
+static inline quint64 shortcutLength(quint64 n, quint64 floor, quint64 &length) {
+    unsigned zeros = qCountTrailingZeroBits(n);
+    n >>= zeros;
+    length += zeros;
+    while (n >= floor && n != 1) {
+        if (n > Collatz3x1::maxMultipliable) {
+            throw std::overflow_error("64-bit integer overflow during calculation");
+        }
+        n = 3 * n + 1;
+        zeros = qCountTrailingZeroBits(n);
+        n >>= zeros;
+        length += 1 + zeros;
+    }
+    return n;
+}
+
+// Kernel functors: processRange() is instantiated once per kernel,
+// so the choice costs nothing inside the per-value loop.
+struct PlainKernel {
+    quint64 operator()(quint64 start) const {
+        return collatzLength(start);
+    }
+};
+
+struct ShortcutKernel {
+    quint64 operator()(quint64 start) const {
+        quint64 length = 1;
+        shortcutLength(start, 2, length);
+        return length;
+    }
+};
+
+struct MemoKernel {
+    const std::vector<quint16> *memo;  // memo[n] = chain length of n, for n < memo->size().
+
+    quint64 operator()(quint64 start) const {
+        quint64 memoHits = 0;
+        return (*this)(start, memoHits);
+    }
+
+    // Also counts the chains that were finished from the table rather than iterated down to 1.
+    quint64 operator()(quint64 start, quint64 &memoHits) const {
+        quint64 length = 1;
+        quint64 n = shortcutLength(start, memo->size(), length);
+        memoHits += n > 1;
+        return length + (*memo)[n] - 1;
+    }
+};
+
+struct PackedMemoKernel {
+    const CollatzPackedMemo *memo;  // Chain lengths of the odd values below memo->size().
+
+    quint64 operator()(quint64 start) const {
+        quint64 memoHits = 0;
+        return (*this)(start, memoHits);
+    }
+
+    quint64 operator()(quint64 start, quint64 &memoHits) const {
+        quint64 length = 1;
+        quint64 n = shortcutLength(start, memo->size(), length);  // Odd (or 1) once below the floor.
+        memoHits += n > 1;
+        return length + memo->length(n) - 1;
+    }
+};
+
+// Builds the chain length table for [0, size). Every entry is derived from a smaller,
+// already known one, so the cost is a few steps per entry.
+static std::vector<quint16> buildMemo(quint64 size) {
+    std::vector<quint16> memo(size, 0);
+    if (size > 1) {
+        memo[1] = 1;
+    }
+    for (quint64 i = 2; i < size; ++i) {
+        if ((i & 1ULL) == 0ULL) {
+            memo[i] = memo[i >> 1] + 1;
+        } else {
+            quint64 length = 1;
+            quint64 n = shortcutLength(i, i, length);
+            memo[i] = static_cast<quint16>(length + memo[n] - 1);
+        }
+    }
+    return memo;
+}
+
 // Structure to store intermediate results in a subrange.
 struct RangeResult {
     quint64 bestNumber;
     quint64 bestLength;
 };
 
+// Buffer the calling worker records into, or nullptr if the calculation is not traced.
+static CollatzTraceBuffer *traceBuffer(CollatzTrace *trace) {
+    if constexpr (kCollatzTracing) {
+        if (trace) {
+            return trace->threadBuffer();
+        }
+    }
+    return nullptr;
+}
+
 // Function that processes the range [start, end] and finds the number with the longest Collatz sequence.
 // If stopFlag is set, processing is terminated early.
-static RangeResult processRange(quint64 start, quint64 end, std::atomic_bool &stopFlag) {
+// With a trace buffer the range is recorded as one block event.
+template <typename Kernel>
+static RangeResult processRange(quint64 start, quint64 end, std::atomic_bool &stopFlag, const Kernel &kernel,
+                                CollatzTraceBuffer *trace = nullptr) {
     RangeResult result { 0, 0 };
-    for (quint64 i = start; i <= end; ++i) {
+    quint64 memoHits = 0;
+    quint64 begin = 0;
+    quint32 cpu = 0;
+    if constexpr (kCollatzTracing) {
+        if (trace) {
+            begin = CollatzTraceBuffer::now(cpu);
+        }
+    }
+    quint64 i = start;
+    for (; i <= end; ++i) {
         if (stopFlag.load()) {
+            if constexpr (kCollatzTracing) {
+                if (trace) {
+                    trace->instant(CollatzTraceKind::Cancel, i);
+                }
+            }
             break;
         }
-        quint64 length = collatzLength(i);
+        quint64 length;
+        if constexpr (kCollatzTracing && std::is_invocable_v<const Kernel &, quint64, quint64 &>) {
+            length = kernel(i, memoHits);
+        } else {
+            length = kernel(i);
+        }
         if (length > result.bestLength) {
             result.bestLength = length;
             result.bestNumber = i;
         }
     }
+    if constexpr (kCollatzTracing) {
+        if (trace) {
+            trace->record({ begin, CollatzTraceBuffer::now(), start, i - 1, memoHits, cpu, CollatzTraceKind::Block });
+        }
+    }
     return result;
 }
 
-CollatzResult CollatzCalculator::calculate(quint64 limit, int numThreads, std::atomic_bool &stopFlag) {
-    QElapsedTimer timer;
-    timer.start();
+// Worker for static scheduling: one contiguous chunk.
+template <typename Kernel>
+static RangeResult processChunk(quint64 start, quint64 end, std::atomic_bool &stopFlag, const Kernel &kernel,
+                                CollatzTrace *trace) {
+    return processRange(start, end, stopFlag, kernel, traceBuffer(trace));
+}
+
+// Worker for dynamic scheduling: repeatedly grabs the next block of blockSize values.
+// Threads that finish early simply take more blocks, so no thread is left waiting
+// for a straggler that got the expensive part of the range.
+template <typename Kernel>
+static RangeResult processBlocks(quint64 limit, quint64 blockSize, std::atomic<quint64> &nextStart,
+                                 std::atomic_bool &stopFlag, const Kernel &kernel, CollatzTrace *trace) {
+    CollatzTraceBuffer *buffer = traceBuffer(trace);
+    RangeResult result { 0, 0 };
+    while (!stopFlag.load()) {
+        quint64 start = nextStart.fetch_add(blockSize, std::memory_order_relaxed);
+        if constexpr (kCollatzTracing) {
+            if (buffer) {
+                buffer->instant(CollatzTraceKind::Claim, start);  // Past the limit: the worker ran out of work.
+            }
+        }
+        if (start > limit) {
+            break;
+        }
+        quint64 end = (limit - start < blockSize) ? limit : start + blockSize - 1;
+        RangeResult blockResult = processRange(start, end, stopFlag, kernel, buffer);
+        if (blockResult.bestLength > result.bestLength) {
+            result = blockResult;
+        }
+    }
+    return result;
+}
 
+template <typename Kernel>
+static RangeResult runKernel(quint64 limit, const CollatzOptions &options, std::atomic_bool &stopFlag, const Kernel &kernel) {
+    int numThreads = options.numThreads > 0 ? options.numThreads : 1;
     QList<QFuture<RangeResult>> futures;
+    std::atomic<quint64> nextStart { 1 };
 
-    // Divide the range [1, limit] into approximately equal parts.
-    quint64 chunkSize = limit / numThreads;
-    if (chunkSize == 0) {
-        chunkSize = 1;
-    }
-    quint64 currentStart = 1;
-    for (int i = 0; i < numThreads && currentStart <= limit; ++i) {
-        quint64 currentEnd = (i == numThreads - 1) ? limit : (currentStart + chunkSize - 1);
-        QFuture<RangeResult> future = QtConcurrent::run(processRange, currentStart, currentEnd, std::ref(stopFlag));
-        futures.append(future);
-        currentStart = currentEnd + 1;
+    if (options.blockSize > 0) {
+        for (int i = 0; i < numThreads; ++i) {
+            futures.append(QtConcurrent::run(processBlocks<Kernel>, limit, options.blockSize,
+                                             std::ref(nextStart), std::ref(stopFlag), std::cref(kernel), options.trace));
+        }
+    } else {
+        // Divide the range [1, limit] into approximately equal parts.
+        quint64 chunkSize = limit / numThreads;
+        if (chunkSize == 0) {
+            chunkSize = 1;
+        }
+        quint64 currentStart = 1;
+        for (int i = 0; i < numThreads && currentStart <= limit; ++i) {
+            quint64 currentEnd = (i == numThreads - 1) ? limit : (currentStart + chunkSize - 1);
+            futures.append(QtConcurrent::run(processChunk<Kernel>, currentStart, currentEnd,
+                                             std::ref(stopFlag), std::cref(kernel), options.trace));
+            currentStart = currentEnd + 1;
+        }
     }
 
-    // Gather results from each subrange.
+    // Gather results from each subrange. Ties are resolved towards the smaller number,
+    // so the answer does not depend on which thread happened to take which block.
     RangeResult globalResult { 0, 0 };
     for (auto &future : futures) {
         future.waitForFinished();
         RangeResult localResult = future.result();
-        if (localResult.bestLength > globalResult.bestLength) {
+        if (localResult.bestLength > globalResult.bestLength
+            || (localResult.bestLength == globalResult.bestLength && localResult.bestNumber < globalResult.bestNumber)) {
             globalResult = localResult;
         }
     }
+    return globalResult;
+}
+
+// Builds a memo table, recorded as one event when the calculation is traced.
+template <typename Build>
+static auto tracedMemoBuild(CollatzTrace *trace, quint64 memoSize, Build build) {
+    quint64 begin = 0;
+    quint32 cpu = 0;
+    if constexpr (kCollatzTracing) {
+        begin = CollatzTraceBuffer::now(cpu);
+    }
+    auto memo = build();
+    if constexpr (kCollatzTracing) {
+        if (CollatzTraceBuffer *buffer = traceBuffer(trace)) {
+            buffer->record({ begin, CollatzTraceBuffer::now(), 0, memoSize - 1, 0, cpu, CollatzTraceKind::MemoBuild });
+        }
+    }
+    return memo;
+}
+
+CollatzResult CollatzCalculator::calculate(quint64 limit, int numThreads, std::atomic_bool &stopFlag) {
+    CollatzOptions options;
+    options.numThreads = numThreads;
+    return calculate(limit, options, stopFlag);
+}
+
+CollatzResult CollatzCalculator::calculate(quint64 limit, const CollatzOptions &options, std::atomic_bool &stopFlag) {
+    QElapsedTimer timer;
+    timer.start();
+
+    RangeResult globalResult { 0, 0 };
+    switch (options.kernel) {
+    case CollatzKernel::Plain:
+        globalResult = runKernel(limit, options, stopFlag, PlainKernel {});
+        break;
+    case CollatzKernel::Shortcut:
+        globalResult = runKernel(limit, options, stopFlag, ShortcutKernel {});
+        break;
+    case CollatzKernel::Memo:
+    case CollatzKernel::PackedMemo: {
+        // A table larger than the range itself is never consulted.
+        quint64 memoSize = qMin(options.memoSize, limit + 1);
+        if (memoSize < 2) {
+            globalResult = runKernel(limit, options, stopFlag, ShortcutKernel {});
+            break;
+        }
+        if (options.kernel == CollatzKernel::Memo) {
+            std::vector<quint16> memo = tracedMemoBuild(options.trace, memoSize, [memoSize] { return buildMemo(memoSize); });
+            globalResult = runKernel(limit, options, stopFlag, MemoKernel { &memo });
+        } else {
+            CollatzPackedMemo memo = tracedMemoBuild(options.trace, memoSize, [memoSize] { return CollatzPackedMemo(memoSize); });
+            globalResult = runKernel(limit, options, stopFlag, PackedMemoKernel { &memo });
+        }
+        break;
+    }
+    }
 
     qint64 elapsed = timer.elapsed();
     CollatzResult result;
@@ -107,3 +333,145 @@ CollatzTestResult CollatzCalculator::getTestSequence(quint64 start) {
     res.sequence = seq;
     return res;
 }
+
+// Number of chains CollatzLengthOracle::lengths() advances side by side.
+static constexpr size_t kOracleLanes = 8;
+
+CollatzLengthOracle::CollatzLengthOracle(quint64 memoSize)
+    : memo(buildMemo(qMax<quint64>(memoSize, 2)))
+{
+}
+
+void CollatzLengthOracle::lengths(const quint64 *values, quint64 *lengths, size_t count) const {
+    const quint64 floor = memo.size();
+    quint64 n[kOracleLanes];
+    quint64 length[kOracleLanes];
+    size_t index[kOracleLanes];
+    size_t next = 0;
+
+    // Loads the next value that needs iterating into 'lane'. Values that are
+    // invalid or already in the table are answered on the spot.
+    auto refill = [&](size_t lane) {
+        while (next < count) {
+            size_t i = next++;
+            quint64 v = values[i];
+            if (v == 0) {
+                lengths[i] = 0;
+                continue;
+            }
+            unsigned zeros = qCountTrailingZeroBits(v);
+            v >>= zeros;
+            if (v < floor) {
+                lengths[i] = zeros + memo[v];
+                continue;
+            }
+            n[lane] = v;
+            length[lane] = 1 + zeros;
+            index[lane] = i;
+            return true;
+        }
+        return false;
+    };
+
+    size_t lanes = 0;
+    while (lanes < kOracleLanes && refill(lanes)) {
+        ++lanes;
+    }
+    while (lanes > 0) {
+        for (size_t lane = 0; lane < lanes;) {
+            // One odd step plus the halvings that follow it (the Shortcut kernel step).
+            quint64 v = n[lane];
+            bool finished = true;
+            if (v > Collatz3x1::maxMultipliable) {
+                lengths[index[lane]] = 0;
+            } else {
+                v = 3 * v + 1;
+                unsigned zeros = qCountTrailingZeroBits(v);
+                v >>= zeros;
+                length[lane] += 1 + zeros;
+                n[lane] = v;
+                finished = v < floor;
+                if (finished) {
+                    lengths[index[lane]] = length[lane] + memo[v] - 1;
+                }
+            }
+            if (finished && !refill(lane)) {
+                // No more work: the last lane takes this slot.
+                --lanes;
+                n[lane] = n[lanes];
+                length[lane] = length[lanes];
+                index[lane] = index[lanes];
+                continue;
+            }
+            ++lane;
+        }
+    }
+}
+
+std::vector<quint64> CollatzLengthOracle::sequence(quint64 start) {
+    std::vector<quint64> values;
+    if (start == 0) {
+        return values;
+    }
+    Orbit<quint64> orbit = Engine3x1::run(start, ~0ULL, [&values](quint64 n) { values.push_back(n); });
+    if (orbit.status == OrbitStatus::Overflow) {
+        values.clear();
+    }
+    return values;
+}
+
+QString CollatzCalculator::kernelName(CollatzKernel kernel) {
+    switch (kernel) {
+    case CollatzKernel::Plain:      return QStringLiteral("plain");
+    case CollatzKernel::Shortcut:   return QStringLiteral("shortcut");
+    case CollatzKernel::Memo:       return QStringLiteral("memo");
+    case CollatzKernel::PackedMemo: return QStringLiteral("packed");
+    }
+    return QString();
+}
+
+// Nanoseconds per lookup of random odd values below size. Dependent: every position is
+// derived from the previous result, so the loads cannot overlap and the time is the latency.
+template <typename Lookup>
+static double lookupNs(quint64 size, quint64 lookups, bool dependent, Lookup lookup) {
+    QElapsedTimer timer;
+    timer.start();
+    quint64 state = 0x243F6A8885A308D3ULL;
+    quint64 sum = 0;
+    for (quint64 i = 0; i < lookups; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL + (dependent ? sum : 0);
+        quint64 n = ((state >> 16) % (size / 2)) * 2 + 1;
+        sum += lookup(n);
+    }
+    volatile quint64 sink = sum;  // Keeps the loop.
+    (void)sink;
+    return static_cast<double>(timer.nsecsElapsed()) / lookups;
+}
+
+CollatzMemoComparison CollatzCalculator::compareMemoTables(quint64 size, quint64 lookups) {
+    size = qMax<quint64>(size, 4);
+    CollatzMemoComparison report {};
+    report.size = size;
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<quint16> memo = buildMemo(size);
+    report.plainBuildMs = timer.restart();
+    CollatzPackedMemo packed(size);
+    report.packedBuildMs = timer.elapsed();
+
+    report.plainBytes = memo.size() * sizeof(quint16);
+    report.packedBytes = packed.bytes();
+    report.escapes = packed.escapes();
+    for (quint64 n = 1; n < size; n += 2) {
+        report.mismatches += packed.length(n) != memo[n];
+    }
+
+    auto plainLookup = [&memo](quint64 n) -> quint64 { return memo[n]; };
+    auto packedLookup = [&packed](quint64 n) { return packed.length(n); };
+    report.plainLatencyNs = lookupNs(size, lookups, true, plainLookup);
+    report.packedLatencyNs = lookupNs(size, lookups, true, packedLookup);
+    report.plainThroughputNs = lookupNs(size, lookups, false, plainLookup);
+    report.packedThroughputNs = lookupNs(size, lookups, false, packedLookup);
+    return report;
+}
@@ -4,6 +4,9 @@
 #include <QtGlobal>
 #include <atomic>
 #include <QString>
+#include <vector>
+
+class CollatzTrace;
 
 // Structure to store the full calculation result for a range.
 struct CollatzResult {
@@ -19,6 +22,40 @@ struct CollatzTestResult {
     QString sequence;    // The complete sequence (e.g. "13 → 40 → 20 → ... → 1").
 };
 
+// Inner loop used to compute the chain length of every value in the range.
+enum class CollatzKernel {
+    Plain,     // One rule application per iteration (the reference implementation).
+    Shortcut,  // Strips a whole run of trailing zero bits with a single shift.
+    Memo,      // Shortcut kernel that stops once the value drops into a precomputed table.
+    PackedMemo // Memo kernel with the table of CollatzPackedMemo: about 4.5 bits per value instead of 16.
+};
+
+// Tunable parameters of a range calculation.
+// The defaults reproduce the original behaviour: plain kernel, one contiguous chunk per thread.
+struct CollatzOptions {
+    int numThreads = 1;                          // Number of worker threads.
+    quint64 blockSize = 0;                       // Values per dynamically scheduled block (0 = static split).
+    quint64 memoSize = 0;                        // Values covered by the memo table (Memo and PackedMemo kernels).
+    CollatzKernel kernel = CollatzKernel::Plain; // Inner loop variant.
+    CollatzTrace *trace = nullptr;               // Timeline recorder (only used in builds with COLLATZ_TRACING).
+};
+
+// Memory and lookup cost of the plain quint16 memo table and of CollatzPackedMemo
+// for the same values (see CollatzCalculator::compareMemoTables).
+struct CollatzMemoComparison {
+    quint64 size;                // Values [0, size) covered by both tables.
+    quint64 plainBytes;
+    quint64 packedBytes;
+    quint64 escapes;             // Packed entries kept in the outlier hash table.
+    quint64 mismatches;          // Odd values whose lengths differ (0 unless there is a bug).
+    qint64 plainBuildMs;
+    qint64 packedBuildMs;
+    double plainLatencyNs;       // Random lookups, each depending on the previous result.
+    double packedLatencyNs;
+    double plainThroughputNs;    // Random independent lookups.
+    double packedThroughputNs;
+};
+
 class CollatzCalculator {
 public:
     // Main calculation function for the range [1, limit].
@@ -26,10 +63,37 @@ public:
     // Throws std::overflow_error if an overflow occurs.
     static CollatzResult calculate(quint64 limit, int numThreads, std::atomic_bool &stopFlag);
 
+    // Same as above, but with full control over kernel, scheduling and memo size.
+    static CollatzResult calculate(quint64 limit, const CollatzOptions &options, std::atomic_bool &stopFlag);
+
     // Test function: computes the Collatz sequence for a single starting value.
     // It returns both the sequence (as a string) and its length.
     // This is intended only for test cases.
     static CollatzTestResult getTestSequence(quint64 start);
+
+    // Builds both memo tables for [0, size), checks that they agree and times 'lookups' random lookups in each.
+    static CollatzMemoComparison compareMemoTables(quint64 size, quint64 lookups);
+
+    // Human-readable kernel name (used in reports and in the saved tuning profile).
+    static QString kernelName(CollatzKernel kernel);
+};
+
+// Chain lengths of arbitrary, scattered values (e.g. requests collected by the query daemon).
+// The memo table is built once and stays warm between calls.
+class CollatzLengthOracle {
+public:
+    explicit CollatzLengthOracle(quint64 memoSize);
+
+    // lengths[i] = chain length of values[i], or 0 if values[i] is 0 or the chain overflows 64 bits.
+    // Several chains are advanced in an interleaved fashion, so the CPU works on
+    // independent dependency chains at the same time instead of one long one.
+    void lengths(const quint64 *values, quint64 *lengths, size_t count) const;
+
+    // Full sequence of a single value (empty if it overflows).
+    static std::vector<quint64> sequence(quint64 start);
+
+private:
+    std::vector<quint16> memo;
 };
 
 #endif // COLLATZCALCULATOR_H
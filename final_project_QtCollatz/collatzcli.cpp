@@ -0,0 +1,309 @@
+#include "collatzcli.h"
+#include "collatzcalculator.h"
+#include "collatztrace.h"
+#include "collatzinversetree.h"
+#include "collatzserver.h"
+#include "collatzloadgen.h"
+#include "collatzsampler.h"
+#include "collatzverifier.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QThread>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+// Parses a non-negative integer option value; throws std::invalid_argument on bad input.
+static quint64 unsignedValue(const QCommandLineParser &parser, const QCommandLineOption &option) {
+    bool ok = false;
+    quint64 value = parser.value(option).toULongLong(&ok);
+    if (!ok) {
+        throw std::invalid_argument(QString("invalid value for --%1: %2")
+                                        .arg(option.names().first(), parser.value(option))
+                                        .toStdString());
+    }
+    return value;
+}
+
+// --inverse: prints "<value> <length>" lines, grouped by chain length and sorted within each group.
+static int runInverse(quint64 maxLength, quint64 maxValue, bool exactOnly, int numThreads) {
+    QTextStream out(stdout);
+    std::atomic_bool stopFlag(false);
+    CollatzInverseTree::generate(maxLength, maxValue, numThreads, stopFlag,
+                                 [&out, maxLength, exactOnly](quint64 length, const std::vector<quint64> &values) {
+                                     if (exactOnly && length != maxLength) {
+                                         return;
+                                     }
+                                     for (quint64 value : values) {
+                                         out << value << ' ' << length << '\n';
+                                     }
+                                 });
+    return 0;
+}
+
+// --daemon: serves queries until the process is terminated.
+static int runDaemon(const QString &name, quint64 memoSize) {
+    CollatzServer server(memoSize);
+    if (!server.listen(name)) {
+        QTextStream(stderr) << "Error: cannot listen on " << name << ": " << server.errorString() << '\n';
+        return 1;
+    }
+    QTextStream(stdout) << "Listening on " << name << '\n';
+    return QCoreApplication::exec();
+}
+
+// --loadgen: drives a running daemon and prints latency and throughput.
+static int runLoadGen(const CollatzLoadOptions &options) {
+    CollatzLoadReport report = CollatzLoadGen::run(options);
+    QTextStream out(stdout);
+    out << "Requests: " << report.requests << " (errors: " << report.errors << ")\n"
+        << "Time:     " << report.seconds << " s\n"
+        << "QPS:      " << qRound64(report.qps) << '\n'
+        << "p50:      " << report.p50Us << " us\n"
+        << "p99:      " << report.p99Us << " us\n";
+    return report.errors == 0 ? 0 : 1;
+}
+
+// --verify: checks that every value of the range drops below itself; lists the values that did not.
+static int runVerify(quint64 first, quint64 last, const CollatzVerifyOptions &options) {
+    std::atomic_bool stopFlag(false);
+    CollatzVerifyResult result = CollatzVerifier::verify(first, last, options, stopFlag);
+    QTextStream out(stdout);
+    out << "Checked:  " << result.checked << " values\n"
+        << "Iterated: " << result.iterated << " (after the 2^" << options.sieveBits << " sieve)\n"
+        << "Time:     " << result.timeMs << " ms\n"
+        << "Rate:     " << qRound64(result.checked / (qMax<qint64>(1, result.timeMs) / 1000.0)) << " values/s\n"
+        << "Exceeded: " << result.exceededCount << " (more than " << options.maxSteps << " steps)\n";
+    for (quint64 n : result.exceeded) {
+        out << "  " << n << '\n';
+    }
+    out << "Overflow: " << result.overflowCount << '\n';
+    for (quint64 n : result.overflowed) {
+        out << "  " << n << '\n';
+    }
+    return result.exceededCount == 0 && result.overflowCount == 0 ? 0 : 1;
+}
+
+// --search: the longest chain in [1, <limit>], optionally with a timeline trace of the workers.
+static int runSearch(quint64 limit, const CollatzOptions &options, const QString &tracePath) {
+    std::atomic_bool stopFlag(false);
+    CollatzOptions traced = options;
+    std::unique_ptr<CollatzTrace> trace;
+    if (!tracePath.isEmpty()) {
+        if (!kCollatzTracing) {
+            QTextStream(stderr) << "Error: --trace needs a build with -DCOLLATZ_TRACING=ON\n";
+            return 1;
+        }
+        trace = std::make_unique<CollatzTrace>();
+        traced.trace = trace.get();
+    }
+    CollatzResult result = CollatzCalculator::calculate(limit, traced, stopFlag);
+    QTextStream out(stdout);
+    out << "Number: " << result.bestNumber << '\n'
+        << "Length: " << result.bestLength << '\n'
+        << "Time:   " << result.timeMs << " ms\n";
+    if (trace) {
+        if (!trace->writeChromeJson(tracePath)) {
+            QTextStream(stderr) << "Error: cannot write " << tracePath << '\n';
+            return 1;
+        }
+        out << "Trace:  " << tracePath << " (" << trace->droppedEvents() << " events dropped)\n";
+    }
+    return 0;
+}
+
+// --memo-bench: memory and lookup cost of the plain and the packed memo table.
+static int runMemoBench(quint64 size, quint64 lookups) {
+    CollatzMemoComparison report = CollatzCalculator::compareMemoTables(size, lookups);
+    QTextStream out(stdout);
+    out << "Values:       " << report.size << '\n'
+        << "              plain (quint16)   packed\n"
+        << "Bytes/value:  " << QString::number(double(report.plainBytes) / report.size, 'f', 3).leftJustified(18)
+        << QString::number(double(report.packedBytes) / report.size, 'f', 3) << '\n'
+        << "Total MB:     " << QString::number(report.plainBytes / 1e6, 'f', 1).leftJustified(18)
+        << QString::number(report.packedBytes / 1e6, 'f', 1) << '\n'
+        << "Build ms:     " << QString::number(report.plainBuildMs).leftJustified(18) << report.packedBuildMs << '\n'
+        << "Latency ns:   " << QString::number(report.plainLatencyNs, 'f', 1).leftJustified(18)
+        << QString::number(report.packedLatencyNs, 'f', 1) << '\n'
+        << "Random ns:    " << QString::number(report.plainThroughputNs, 'f', 1).leftJustified(18)
+        << QString::number(report.packedThroughputNs, 'f', 1) << '\n'
+        << "Escapes:      " << report.escapes << " of " << (report.size / 2) << " odd values\n"
+        << "Mismatches:   " << report.mismatches << '\n';
+    return report.mismatches == 0 ? 0 : 1;
+}
+
+// --sample: estimated chain length distribution of [first, last] from a stratified random sample.
+static int runSample(quint64 first, quint64 last, const CollatzSampleOptions &options, bool printHistogram) {
+    std::atomic_bool stopFlag(false);
+    CollatzSampleResult result = CollatzSampler::sample(first, last, options, stopFlag);
+    QTextStream out(stdout);
+    out << "Samples:  " << result.samples << " in " << result.rounds << " rounds"
+        << (result.converged ? "" : " (precision not reached)") << '\n'
+        << "Time:     " << result.timeMs << " ms\n"
+        << "Mean:     " << QString::number(result.mean, 'f', 3) << " +- " << QString::number(result.meanError, 'f', 3)
+        << " (" << options.confidence * 100 << "% confidence)\n"
+        << "Std dev:  " << QString::number(result.deviation, 'f', 3) << '\n';
+    for (const CollatzQuantile &quantile : result.quantiles) {
+        out << "q" << QString::number(quantile.probability * 100, 'g', 6).leftJustified(8) << quantile.value
+            << "  [" << quantile.low << ", " << quantile.high << "]\n";
+    }
+    out << "Max:      " << (result.histogram.empty() ? 0 : result.histogram.size() - 1) << '\n'
+        << "Overflow: " << result.overflowCount << '\n';
+    if (printHistogram) {
+        for (size_t length = 0; length < result.histogram.size(); ++length) {
+            if (result.histogram[length] != 0) {
+                out << length << ' ' << result.histogram[length] << '\n';
+            }
+        }
+    }
+    return 0;
+}
+
+bool CollatzCli::isRequested(int argc, char *argv[]) {
+    // Single-dash arguments (-style, -platform, ...) belong to QApplication.
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' && argv[i][1] == '-') {
+            return true;
+        }
+    }
+    return false;
+}
+
+int CollatzCli::run(const QCoreApplication &app) {
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Collatz search. Without options the GUI is started.");
+    parser.addHelpOption();
+
+    QCommandLineOption inverseOption("inverse",
+        "Print all numbers with chain length <= <length>, grouped by length (predecessor tree walk).", "length");
+    QCommandLineOption exactOption("exact",
+        "With --inverse: print only the numbers with chain length exactly <length>.");
+    QCommandLineOption maxValueOption("max-value",
+        "Only print numbers <= <n>.", "n");
+    QCommandLineOption threadsOption("threads",
+        "Number of worker threads.", "n", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption daemonOption("daemon",
+        "Serve length/sequence queries on the local socket <name>.", "name");
+    QCommandLineOption memoSizeOption("memo-size",
+        "With --daemon, --search or --sample: entries in the chain length table kept in memory.", "n", QString::number(1 << 20));
+    QCommandLineOption loadGenOption("loadgen",
+        "Send random length queries to the daemon on <name>; report QPS and latency.", "name");
+    QCommandLineOption requestsOption("requests",
+        "With --loadgen: requests per client.", "n", "100000");
+    QCommandLineOption pipelineOption("pipeline",
+        "With --loadgen: requests in flight per client.", "n", "64");
+    QCommandLineOption clientsOption("clients",
+        "With --loadgen: parallel connections.", "n", "1");
+    QCommandLineOption verifyOption("verify",
+        "Verify that every number in [--from, <last>] drops below itself.", "last");
+    QCommandLineOption fromOption("from",
+        "With --verify or --sample: first number of the range.", "n", "1");
+    QCommandLineOption sieveBitsOption("sieve-bits",
+        "With --verify: skip residues mod 2^<k> that provably drop within k steps (1..24).", "k", "20");
+    QCommandLineOption maxStepsOption("max-steps",
+        "With --verify: report numbers still above their start after <n> steps.", "n", "100000");
+    QCommandLineOption searchOption("search",
+        "Find the number in [1, <limit>] with the longest chain.", "limit");
+    QCommandLineOption kernelOption("kernel",
+        "With --search: plain, shortcut, memo or packed (memo with the compressed table).", "name", "memo");
+    QCommandLineOption blockSizeOption("block-size",
+        "With --search: values per dynamically scheduled block (0 = one chunk per thread).", "n", "65536");
+    QCommandLineOption traceOption("trace",
+        "With --search: write a Chrome/Perfetto trace of the worker timeline to <file> (COLLATZ_TRACING builds).", "file");
+    QCommandLineOption memoBenchOption("memo-bench",
+        "Compare the plain and the packed chain length table for the values below <size>.", "size");
+    QCommandLineOption lookupsOption("lookups",
+        "With --memo-bench: random lookups timed per table.", "n", "10000000");
+    QCommandLineOption sampleOption("sample",
+        "Estimate the chain length distribution of [--from, <last>] from a stratified random sample.", "last");
+    QCommandLineOption seedOption("seed",
+        "With --sample: random seed; the same seed gives the same estimates.", "n", "1");
+    QCommandLineOption precisionOption("precision",
+        "With --sample: stop once the mean is known to +-<steps>.", "steps", "0.1");
+    QCommandLineOption maxSamplesOption("max-samples",
+        "With --sample: upper bound on the samples taken.", "n", "10000000");
+    QCommandLineOption strataOption("strata",
+        "With --sample: equal-width slices of the range, each sampled every round.", "n", "1024");
+    QCommandLineOption histogramOption("histogram",
+        "With --sample: also print the sampled \"<length> <count>\" histogram.");
+    parser.addOptions({ inverseOption, exactOption, maxValueOption, threadsOption,
+                        daemonOption, memoSizeOption, loadGenOption, requestsOption, pipelineOption, clientsOption,
+                        verifyOption, fromOption, sieveBitsOption, maxStepsOption,
+                        searchOption, kernelOption, blockSizeOption, traceOption, memoBenchOption, lookupsOption,
+                        sampleOption, seedOption, precisionOption, maxSamplesOption, strataOption, histogramOption });
+    parser.process(app);
+
+    try {
+        int numThreads = static_cast<int>(unsignedValue(parser, threadsOption));
+        quint64 maxValue = parser.isSet(maxValueOption) ? unsignedValue(parser, maxValueOption)
+                                                        : std::numeric_limits<quint64>::max();
+        if (parser.isSet(inverseOption)) {
+            return runInverse(unsignedValue(parser, inverseOption), maxValue,
+                              parser.isSet(exactOption), numThreads);
+        }
+        if (parser.isSet(daemonOption)) {
+            return runDaemon(parser.value(daemonOption), unsignedValue(parser, memoSizeOption));
+        }
+        if (parser.isSet(loadGenOption)) {
+            CollatzLoadOptions options;
+            options.serverName = parser.value(loadGenOption);
+            options.requests = unsignedValue(parser, requestsOption);
+            options.pipeline = qMax(1, static_cast<int>(unsignedValue(parser, pipelineOption)));
+            options.clients = qMax(1, static_cast<int>(unsignedValue(parser, clientsOption)));
+            if (parser.isSet(maxValueOption)) {
+                options.maxValue = qMax<quint64>(1, maxValue);
+            }
+            return runLoadGen(options);
+        }
+        if (parser.isSet(verifyOption)) {
+            CollatzVerifyOptions options;
+            options.numThreads = qMax(1, numThreads);
+            options.sieveBits = static_cast<unsigned>(qBound<quint64>(1, unsignedValue(parser, sieveBitsOption), 24));
+            options.maxSteps = unsignedValue(parser, maxStepsOption);
+            return runVerify(unsignedValue(parser, fromOption), unsignedValue(parser, verifyOption), options);
+        }
+        if (parser.isSet(searchOption)) {
+            CollatzOptions options;
+            options.numThreads = qMax(1, numThreads);
+            options.blockSize = unsignedValue(parser, blockSizeOption);
+            options.memoSize = unsignedValue(parser, memoSizeOption);
+            bool known = false;
+            for (CollatzKernel kernel : { CollatzKernel::Plain, CollatzKernel::Shortcut, CollatzKernel::Memo,
+                                          CollatzKernel::PackedMemo }) {
+                if (CollatzCalculator::kernelName(kernel) == parser.value(kernelOption)) {
+                    options.kernel = kernel;
+                    known = true;
+                }
+            }
+            if (!known) {
+                throw std::invalid_argument(QString("unknown kernel: %1").arg(parser.value(kernelOption)).toStdString());
+            }
+            return runSearch(unsignedValue(parser, searchOption), options, parser.value(traceOption));
+        }
+        if (parser.isSet(sampleOption)) {
+            CollatzSampleOptions options;
+            options.numThreads = qMax(1, numThreads);
+            options.seed = unsignedValue(parser, seedOption);
+            options.maxSamples = unsignedValue(parser, maxSamplesOption);
+            options.strata = qMax<quint64>(1, unsignedValue(parser, strataOption));
+            options.memoSize = unsignedValue(parser, memoSizeOption);
+            bool ok = false;
+            options.precision = parser.value(precisionOption).toDouble(&ok);
+            if (!ok || options.precision < 0) {
+                throw std::invalid_argument(QString("invalid value for --precision: %1")
+                                                .arg(parser.value(precisionOption)).toStdString());
+            }
+            return runSample(unsignedValue(parser, fromOption), unsignedValue(parser, sampleOption), options,
+                             parser.isSet(histogramOption));
+        }
+        if (parser.isSet(memoBenchOption)) {
+            return runMemoBench(unsignedValue(parser, memoBenchOption), qMax<quint64>(1, unsignedValue(parser, lookupsOption)));
+        }
+    } catch (const std::exception &e) {
+        QTextStream(stderr) << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
+    parser.showHelp(1);
+}
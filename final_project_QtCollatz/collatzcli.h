@@ -0,0 +1,17 @@
+#ifndef COLLATZCLI_H
+#define COLLATZCLI_H
+
+class QCoreApplication;
+
+// Command-line modes of the application. They run without creating any widgets,
+// so they can be used from scripts and on machines without a display.
+class CollatzCli {
+public:
+    // True if the arguments select a command-line mode instead of the GUI.
+    static bool isRequested(int argc, char *argv[]);
+
+    // Parses the arguments of 'app' and runs the selected mode. Returns the exit code.
+    static int run(const QCoreApplication &app);
+};
+
+#endif // COLLATZCLI_H
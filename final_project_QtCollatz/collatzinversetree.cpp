@@ -0,0 +1,229 @@
+#include "collatzinversetree.h"
+#include "collatzmap.h"
+#include <QtConcurrent>
+#include <QFuture>
+#include <QList>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+// Frontiers smaller than this are expanded in the calling thread:
+// starting a task would cost more than the work itself.
+static constexpr size_t kMinParallelFrontier = 1 << 14;
+
+// How often (in nodes) a worker checks the stop flag.
+static constexpr size_t kStopCheckInterval = 1 << 12;
+
+static constexpr quint64 kMaxWord = std::numeric_limits<quint64>::max();
+
+// Result of expanding one slice of the frontier.
+struct LevelSlice {
+    std::vector<quint64> next;      // Predecessors that are kept for the next level.
+    std::vector<quint64> reported;  // Predecessors <= maxValue, sorted.
+};
+
+// keepBelow[r] is the largest value that can still have a descendant <= maxValue
+// within the next r levels of the tree.
+//
+// Going down, a value either doubles or becomes (v - 1) / 3, and the latter is odd,
+// so it is always followed by a doubling. The fastest descent therefore alternates
+// the two steps, and j levels down (k = ceil(j/2) divisions, m = floor(j/2) doublings)
+// the smallest descendant is about (v + 2) * 2^m / 3^k - 3. The bound is the maximum
+// of that over j <= r; a small relative margin covers rounding.
+static std::vector<quint64> pruneBounds(quint64 maxLength, quint64 maxValue) {
+    std::vector<quint64> keepBelow(maxLength + 1, kMaxWord);
+    if (maxValue == kMaxWord) {
+        return keepBelow;  // Unbounded query: nothing can be pruned.
+    }
+    keepBelow[0] = maxValue;
+    for (quint64 r = 1; r <= maxLength; ++r) {
+        quint64 k = (r + 1) / 2;
+        quint64 m = r / 2;
+        long double bound = (static_cast<long double>(maxValue) + 3.0L)
+                            * std::pow(3.0L, static_cast<long double>(k))
+                            / std::pow(2.0L, static_cast<long double>(m));
+        bound *= 1.0L + 1e-9L;
+        if (bound >= static_cast<long double>(kMaxWord)) {
+            break;  // This and all further bounds do not fit into 64 bits.
+        }
+        keepBelow[r] = std::max(keepBelow[r - 1], static_cast<quint64>(bound));
+    }
+    return keepBelow;
+}
+
+// Levels of a bounded query by a forward scan of [1, maxValue]: every n follows its chain
+// until it drops below n, where the length is already known. Used when the pruning bounds
+// of the early levels do not fit into 64 bits; the tree would then have to be expanded
+// almost unpruned for those levels, which is far larger than the scanned range.
+static void scanLevels(quint64 maxLength, quint64 maxValue, std::atomic_bool &stopFlag,
+                       const CollatzLevelSink &sink) {
+    std::vector<quint16> lengths(maxValue + 1, 0);
+    std::vector<quint64> counts(maxLength + 1, 0);
+    lengths[1] = 1;
+    counts[1] = 1;
+    for (quint64 n = 2; n <= maxValue; ++n) {
+        if (n % kStopCheckInterval == 0 && stopFlag.load()) {
+            return;
+        }
+        quint64 value = n;
+        quint64 length = 0;
+        while (value >= n) {
+            if (value & 1) {
+                if (value > Collatz3x1::maxMultipliable) {
+                    throw std::overflow_error("64-bit integer overflow during calculation");
+                }
+                value = 3 * value + 1;
+            } else {
+                value >>= 1;
+            }
+            ++length;
+        }
+        length += lengths[value];
+        lengths[n] = static_cast<quint16>(length);
+        if (length <= maxLength) {
+            ++counts[length];
+        }
+    }
+
+    // Bucket the values by length; ascending n keeps every level sorted.
+    std::vector<quint64> offsets(maxLength + 2, 0);
+    for (quint64 length = 1; length <= maxLength; ++length) {
+        offsets[length + 1] = offsets[length] + counts[length];
+    }
+    std::vector<quint64> values(offsets[maxLength + 1]);
+    std::vector<quint64> fill(offsets.begin(), offsets.end() - 1);
+    for (quint64 n = 1; n <= maxValue; ++n) {
+        if (lengths[n] <= maxLength) {
+            values[fill[lengths[n]]++] = n;
+        }
+    }
+    std::vector<quint64>().swap(fill);
+    std::vector<quint16>().swap(lengths);
+
+    for (quint64 length = 1; length <= maxLength && !stopFlag.load(); ++length) {
+        sink(length, std::vector<quint64>(values.begin() + offsets[length], values.begin() + offsets[length + 1]));
+    }
+}
+
+// Expands frontier[begin, end) into the next level.
+static LevelSlice expandSlice(const std::vector<quint64> *frontier, size_t begin, size_t end,
+                              quint64 keepBelow, quint64 maxValue, std::atomic_bool *stopFlag) {
+    LevelSlice slice;
+    slice.next.reserve((end - begin) * 4 / 3 + 1);
+    for (size_t i = begin; i < end; ++i) {
+        if ((i - begin) % kStopCheckInterval == 0 && stopFlag->load()) {
+            break;
+        }
+        quint64 n = (*frontier)[i];
+
+        // 2n: always a predecessor. In a bounded query a predecessor beyond 64 bits can be
+        // skipped: every ancestor of a reported value lies on that value's own trajectory,
+        // which the bound keeps within 64 bits.
+        if (n <= kMaxWord / 2) {
+            quint64 doubled = n << 1;
+            if (doubled <= keepBelow) {
+                slice.next.push_back(doubled);
+            }
+        } else if (maxValue == kMaxWord) {
+            throw std::overflow_error("64-bit integer overflow during calculation");
+        }
+
+        // (n - 1) / 3: a predecessor if it is an odd integer, i.e. n % 6 == 4.
+        // 1 is excluded, it is the root of the tree (1 -> 4 -> 2 -> 1).
+        if (n % 6 == 4) {
+            quint64 third = (n - 1) / 3;
+            if (third > 1 && third <= keepBelow) {
+                slice.next.push_back(third);
+            }
+        }
+    }
+
+    for (quint64 value : slice.next) {
+        if (value <= maxValue) {
+            slice.reported.push_back(value);
+        }
+    }
+    std::sort(slice.reported.begin(), slice.reported.end());
+    return slice;
+}
+
+void CollatzInverseTree::generate(quint64 maxLength, quint64 maxValue, int numThreads,
+                                  std::atomic_bool &stopFlag, const CollatzLevelSink &sink) {
+    if (maxLength == 0 || maxValue == 0) {
+        return;
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    std::vector<quint64> keepBelow = pruneBounds(maxLength, maxValue);
+    if (maxValue != kMaxWord && keepBelow[maxLength - 1] == kMaxWord) {
+        scanLevels(maxLength, maxValue, stopFlag, sink);
+        return;
+    }
+
+    std::vector<quint64> frontier { 1 };
+    sink(1, frontier);
+
+    for (quint64 length = 2; length <= maxLength; ++length) {
+        if (stopFlag.load()) {
+            return;
+        }
+        quint64 bound = keepBelow[maxLength - length];
+
+        // Partition the frontier into equal slices, one per thread.
+        int slices = frontier.size() < kMinParallelFrontier ? 1 : numThreads;
+        size_t sliceSize = (frontier.size() + slices - 1) / slices;
+        QList<LevelSlice> results;
+        if (slices == 1) {
+            results.append(expandSlice(&frontier, 0, frontier.size(), bound, maxValue, &stopFlag));
+        } else {
+            QList<QFuture<LevelSlice>> futures;
+            for (size_t begin = 0; begin < frontier.size(); begin += sliceSize) {
+                size_t end = std::min(frontier.size(), begin + sliceSize);
+                futures.append(QtConcurrent::run(expandSlice, &frontier, begin, end, bound, maxValue, &stopFlag));
+            }
+            for (auto &future : futures) {
+                future.waitForFinished();
+                results.append(future.result());
+            }
+        }
+        if (stopFlag.load()) {
+            return;
+        }
+
+        // Concatenate the next frontier and merge the sorted reports of all slices.
+        size_t nextSize = 0;
+        size_t reportedSize = 0;
+        for (const LevelSlice &slice : results) {
+            nextSize += slice.next.size();
+            reportedSize += slice.reported.size();
+        }
+        std::vector<quint64> next;
+        std::vector<quint64> reported;
+        next.reserve(nextSize);
+        reported.reserve(reportedSize);
+        for (LevelSlice &slice : results) {
+            next.insert(next.end(), slice.next.begin(), slice.next.end());
+            auto middle = reported.insert(reported.end(), slice.reported.begin(), slice.reported.end());
+            std::inplace_merge(reported.begin(), middle, reported.end());
+            slice = LevelSlice();
+        }
+        results.clear();
+
+        frontier.swap(next);
+        sink(length, reported);
+    }
+}
+
+std::vector<quint64> CollatzInverseTree::valuesWithLength(quint64 length, quint64 maxValue, int numThreads,
+                                                          std::atomic_bool &stopFlag) {
+    std::vector<quint64> result;
+    generate(length, maxValue, numThreads, stopFlag,
+             [&result, length](quint64 level, const std::vector<quint64> &values) {
+                 if (level == length) {
+                     result = values;
+                 }
+             });
+    return result;
+}
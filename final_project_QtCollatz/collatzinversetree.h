@@ -0,0 +1,36 @@
+#ifndef COLLATZINVERSETREE_H
+#define COLLATZINVERSETREE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// Receives all values with one chain length, sorted ascending.
+// Levels are delivered in order of increasing length, starting with length 1 ({1}).
+using CollatzLevelSink = std::function<void(quint64 length, const std::vector<quint64> &values)>;
+
+// Generates numbers by chain length, walking the Collatz predecessor tree from 1:
+// the predecessors of n are 2n and, if n % 6 == 4, (n - 1) / 3.
+// Every number is produced exactly once, at the level equal to its chain length,
+// so the cost depends on the size of the tree, not on the magnitude of the values.
+class CollatzInverseTree {
+public:
+    // Calls sink for every chain length from 1 to maxLength.
+    // Only values <= maxValue are reported. Branches that cannot come back to
+    // maxValue or below within the remaining levels are not expanded, which keeps
+    // both time and memory proportional to the reported values.
+    // Only two levels of the tree are kept in memory at any time. Each level is
+    // expanded by numThreads threads, every thread taking one slice of the frontier.
+    // Bounded queries whose lengths are too long for the pruning bounds to fit into
+    // 64 bits scan [1, maxValue] forward instead (2 bytes per value, one thread).
+    // Throws std::overflow_error if an unbounded query needs values beyond 64 bits.
+    static void generate(quint64 maxLength, quint64 maxValue, int numThreads,
+                         std::atomic_bool &stopFlag, const CollatzLevelSink &sink);
+
+    // All values <= maxValue with chain length exactly 'length', sorted ascending.
+    static std::vector<quint64> valuesWithLength(quint64 length, quint64 maxValue, int numThreads,
+                                                 std::atomic_bool &stopFlag);
+};
+
+#endif // COLLATZINVERSETREE_H
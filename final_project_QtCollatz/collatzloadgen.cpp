@@ -0,0 +1,112 @@
+#include "collatzloadgen.h"
+#include "collatzprotocol.h"
+#include <QLocalSocket>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QFuture>
+#include <QList>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace CollatzProtocol;
+
+// How long a client waits for the daemon before giving up.
+static constexpr int kTimeoutMs = 5000;
+
+struct ClientResult {
+    std::vector<qint64> latenciesNs;
+    quint64 errors;
+};
+
+// One connection: keeps 'pipeline' requests in flight until all of them are answered.
+// Uses the blocking QLocalSocket API, so it runs in a plain worker thread without an event loop.
+static ClientResult runClient(CollatzLoadOptions options, int client, const QElapsedTimer *clock) {
+    QLocalSocket socket;
+    socket.connectToServer(options.serverName);
+    if (!socket.waitForConnected(kTimeoutMs)) {
+        throw std::runtime_error(QString("cannot connect to %1: %2")
+                                     .arg(options.serverName, socket.errorString()).toStdString());
+    }
+
+    std::mt19937_64 random(options.seed + client);
+    std::uniform_int_distribution<quint64> values(1, options.maxValue);
+    std::vector<qint64> sentAt(options.requests);
+
+    ClientResult result { {}, 0 };
+    result.latenciesNs.reserve(options.requests);
+    quint64 sent = 0;
+    QByteArray out;
+    QByteArray in;
+    while (result.latenciesNs.size() < options.requests) {
+        out.clear();
+        while (sent < options.requests && sent - result.latenciesNs.size() < quint64(options.pipeline)) {
+            quint32 id = static_cast<quint32>(sent);
+            appendRequest(out, { id, OpLength, values(random) });
+            sentAt[sent++] = clock->nsecsElapsed();
+        }
+        if (!out.isEmpty()) {
+            socket.write(out);
+            socket.flush();
+        }
+
+        if (!socket.waitForReadyRead(kTimeoutMs)) {
+            throw std::runtime_error("the daemon stopped responding");
+        }
+        in.append(socket.readAll());
+        qint64 now = clock->nsecsElapsed();
+        int count = in.size() / kResponseSize;
+        for (int i = 0; i < count; ++i) {
+            Response response = readResponse(in.constData() + i * kResponseSize);
+            result.latenciesNs.push_back(now - sentAt[response.id]);
+            if (response.status != StatusOk) {
+                ++result.errors;
+            }
+        }
+        in.remove(0, count * kResponseSize);
+    }
+    return result;
+}
+
+CollatzLoadReport CollatzLoadGen::run(const CollatzLoadOptions &options) {
+    QElapsedTimer clock;
+    clock.start();
+
+    QList<QFuture<ClientResult>> futures;
+    for (int client = 0; client < options.clients; ++client) {
+        futures.append(QtConcurrent::run(runClient, options, client, &clock));
+    }
+
+    std::vector<qint64> latencies;
+    CollatzLoadReport report { 0, 0, 0.0, 0.0, 0.0, 0.0 };
+    for (auto &future : futures) {
+        ClientResult result;
+        try {
+            result = future.result();
+        } catch (const QUnhandledException &ex) {
+            // Unwrap the original exception of the client thread (see MainWindow).
+            if (ex.exception()) {
+                std::rethrow_exception(ex.exception());
+            }
+            throw;
+        }
+        latencies.insert(latencies.end(), result.latenciesNs.begin(), result.latenciesNs.end());
+        report.errors += result.errors;
+    }
+    report.seconds = clock.nsecsElapsed() / 1e9;
+    report.requests = latencies.size();
+    if (latencies.empty()) {
+        return report;
+    }
+
+    report.qps = report.requests / report.seconds;
+    auto percentile = [&latencies](double p) {
+        auto nth = latencies.begin() + static_cast<size_t>(p * (latencies.size() - 1));
+        std::nth_element(latencies.begin(), nth, latencies.end());
+        return *nth / 1000.0;
+    };
+    report.p50Us = percentile(0.50);
+    report.p99Us = percentile(0.99);
+    return report;
+}
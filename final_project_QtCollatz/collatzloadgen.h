@@ -0,0 +1,33 @@
+#ifndef COLLATZLOADGEN_H
+#define COLLATZLOADGEN_H
+
+#include <QtGlobal>
+#include <QString>
+
+// Load generator for the query daemon (see CollatzServer).
+struct CollatzLoadOptions {
+    QString serverName;          // Local socket name the daemon listens on.
+    quint64 requests = 100000;   // Requests per client.
+    int pipeline = 64;           // Requests in flight per client.
+    int clients = 1;             // Parallel connections, one thread each.
+    quint64 maxValue = 1000000;  // Requests ask for uniformly random n in [1, maxValue].
+    quint64 seed = 1;            // Seed of the request stream (client i uses seed + i).
+};
+
+struct CollatzLoadReport {
+    quint64 requests;   // Responses received.
+    quint64 errors;     // Responses with a status other than StatusOk.
+    double seconds;     // Wall-clock time of the whole run.
+    double qps;         // Responses per second, all clients together.
+    double p50Us;       // Median request latency in microseconds.
+    double p99Us;       // 99th percentile request latency in microseconds.
+};
+
+class CollatzLoadGen {
+public:
+    // Runs the load and returns the statistics.
+    // Throws std::runtime_error if the daemon cannot be reached or stops responding.
+    static CollatzLoadReport run(const CollatzLoadOptions &options);
+};
+
+#endif // COLLATZLOADGEN_H
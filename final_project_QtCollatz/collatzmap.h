@@ -0,0 +1,125 @@
+#ifndef COLLATZMAP_H
+#define COLLATZMAP_H
+
+#include <QtGlobal>
+
+// Generalized Collatz map with compile-time constants:
+//   n -> n / D         if D divides n,
+//   n -> Q * n + C     otherwise.
+// AffineMap<quint64, 3, 1> is the classic 3n+1 rule. With D == 2 the divisibility
+// test and the division compile to a bit test and a shift, exactly as in the
+// hand-written loop.
+//
+// Any type with the same interface (word_type and a static apply() that returns
+// false on overflow) can be used with CollatzEngine, e.g. a piecewise map that
+// picks the coefficients by the residue of n.
+template <typename Word, quint64 Q, qint64 C, quint64 D = 2>
+struct AffineMap {
+    static_assert(Q > 0 && D > 1, "multiplier must be positive and divisor greater than one");
+
+    using word_type = Word;
+
+    static constexpr Word multiplier = Q;
+    static constexpr Word divisor = D;
+    static constexpr Word maxWord = static_cast<Word>(~Word(0));
+
+    // Largest n for which Q * n + C still fits into Word.
+    static constexpr Word maxMultipliable = C >= 0
+        ? (maxWord - static_cast<Word>(C)) / multiplier
+        : maxWord / multiplier;
+
+    // Applies one step of the map. Returns false (leaving n untouched) if the result overflows.
+    static inline bool apply(Word &n) {
+        if (n % divisor == 0) {
+            n /= divisor;
+            return true;
+        }
+        if (n > maxMultipliable) {
+            return false;
+        }
+        n = C >= 0 ? multiplier * n + static_cast<Word>(C)
+                   : multiplier * n - static_cast<Word>(-C);
+        return true;
+    }
+};
+
+// Classic rule and a few well-studied relatives.
+using Collatz3x1      = AffineMap<quint64, 3, 1>;
+using Collatz3xMinus1 = AffineMap<quint64, 3, -1>;
+using Collatz5x1      = AffineMap<quint64, 5, 1>;
+
+// How the trajectory ended.
+enum class OrbitStatus {
+    Converged,  // Reached 1.
+    Cycle,      // Entered a cycle that does not contain 1.
+    Diverged,   // Exceeded the step bound.
+    Overflow    // The next value does not fit into the word type.
+};
+
+template <typename Word>
+struct Orbit {
+    OrbitStatus status;
+    quint64 length;       // Number of values visited, including the start (and 1, if converged).
+    Word last;            // Last value that was computed.
+    quint64 cycleLength;  // Period of the detected cycle (status == Cycle only).
+};
+
+// Visitor that ignores every value; it is optimized away completely.
+struct NoOrbitVisitor {
+    template <typename Word>
+    void operator()(Word) const {}
+};
+
+// Iterates a map until the value reaches 1.
+//
+// With Guarded == false this is the bare loop: no cycle detection and no step bound,
+// for maps that are known to converge in the word range (3n+1 on 64 bits).
+// With Guarded == true the loop runs Brent's cycle detection (one comparison per step,
+// a saved value that is refreshed at powers of two) and stops after maxSteps steps,
+// since generalized maps can loop or diverge.
+template <typename Map, bool Guarded = true>
+class CollatzEngine {
+public:
+    using Word = typename Map::word_type;
+
+    // Calls visit(value) for every value of the trajectory, starting with 'start'.
+    // maxSteps is ignored when Guarded == false.
+    template <typename Visitor = NoOrbitVisitor>
+    static Orbit<Word> run(Word start, quint64 maxSteps = ~0ULL, Visitor &&visit = Visitor()) {
+        quint64 length = 1;
+        Word n = start;
+        visit(n);
+
+        // Brent's algorithm state: 'saved' is compared with every new value,
+        // and is moved forward each time 'steps' reaches 'power'.
+        Word saved = n;
+        quint64 power = 1;
+        quint64 steps = 0;
+
+        while (n != 1) {
+            if (Guarded && length > maxSteps) {
+                return { OrbitStatus::Diverged, length, n, 0 };
+            }
+            if (!Map::apply(n)) {
+                return { OrbitStatus::Overflow, length, n, 0 };
+            }
+            length++;
+            visit(n);
+
+            if (Guarded && n != 1) {
+                ++steps;
+                if (n == saved) {
+                    return { OrbitStatus::Cycle, length, n, steps };
+                }
+                if (steps == power) {
+                    saved = n;
+                    power <<= 1;
+                    steps = 0;
+                }
+            }
+        }
+        return { OrbitStatus::Converged, length, n, 0 };
+    }
+};
+
+#endif // COLLATZMAP_H
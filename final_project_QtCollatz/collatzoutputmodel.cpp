@@ -0,0 +1,99 @@
+#include "collatzoutputmodel.h"
+#include <algorithm>
+
+int CollatzOutputModel::Chunk::rows() const {
+    if (values.empty()) {
+        return 1;
+    }
+    return static_cast<int>((values.size() + kValuesPerRow - 1) / kValuesPerRow);
+}
+
+CollatzOutputModel::CollatzOutputModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(kFlushIntervalMs);
+    connect(&flushTimer, &QTimer::timeout, this, [this]() {
+        flush();
+    });
+}
+
+void CollatzOutputModel::appendLine(const QString &text)
+{
+    append({ text, {} });
+}
+
+void CollatzOutputModel::appendSequence(std::vector<quint64> values)
+{
+    if (!values.empty()) {
+        append({ QString(), std::move(values) });
+    }
+}
+
+void CollatzOutputModel::append(Chunk chunk)
+{
+    chunks.push_back(std::move(chunk));
+    if (!flushTimer.isActive()) {
+        flushTimer.start();
+    }
+}
+
+void CollatzOutputModel::clear()
+{
+    flushTimer.stop();
+    beginResetModel();
+    chunks.clear();
+    firstRows.clear();
+    publishedRows = 0;
+    publishedChunks = 0;
+    endResetModel();
+}
+
+void CollatzOutputModel::flush()
+{
+    if (publishedChunks == chunks.size()) {
+        return;
+    }
+    int newRows = 0;
+    for (size_t i = publishedChunks; i < chunks.size(); ++i) {
+        newRows += chunks[i].rows();
+    }
+    // One insertion for everything that arrived since the last frame.
+    beginInsertRows(QModelIndex(), publishedRows, publishedRows + newRows - 1);
+    for (; publishedChunks < chunks.size(); ++publishedChunks) {
+        firstRows.push_back(publishedRows);
+        publishedRows += chunks[publishedChunks].rows();
+    }
+    endInsertRows();
+}
+
+int CollatzOutputModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : publishedRows;
+}
+
+QVariant CollatzOutputModel::data(const QModelIndex &index, int role) const
+{
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= publishedRows) {
+        return QVariant();
+    }
+    int row = index.row();
+    size_t chunkIndex = std::upper_bound(firstRows.begin(), firstRows.end(), row) - firstRows.begin() - 1;
+    const Chunk &chunk = chunks[chunkIndex];
+    if (chunk.values.empty()) {
+        return chunk.text;
+    }
+
+    // "a → b → c", continuation rows start with an arrow.
+    size_t begin = static_cast<size_t>(row - firstRows[chunkIndex]) * kValuesPerRow;
+    size_t end = std::min(chunk.values.size(), begin + kValuesPerRow);
+    QString text;
+    text.reserve(static_cast<int>(end - begin) * 24);
+    for (size_t i = begin; i < end; ++i) {
+        if (i != 0) {
+            text += (i == begin) ? QStringLiteral("→ ") : QStringLiteral(" → ");
+        }
+        text += QString::number(chunk.values[i]);
+    }
+    return text;
+}
@@ -0,0 +1,48 @@
+#ifndef COLLATZOUTPUTMODEL_H
+#define COLLATZOUTPUTMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QTimer>
+#include <vector>
+
+// Output panel contents for a QListView: text lines and whole sequences.
+//
+// Sequences are kept as numbers and split into rows of kValuesPerRow values;
+// a row is formatted only when the view asks for it, so the GUI thread never
+// lays out more text than fits on the screen. Appends are collected and
+// published at most once per frame (kFlushIntervalMs), whatever their number.
+class CollatzOutputModel : public QAbstractListModel
+{
+public:
+    static constexpr int kValuesPerRow = 16;
+    static constexpr int kFlushIntervalMs = 16;
+
+    explicit CollatzOutputModel(QObject *parent = nullptr);
+
+    void appendLine(const QString &text);
+    void appendSequence(std::vector<quint64> values);
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    // A text line (values empty) or a sequence spanning several rows.
+    struct Chunk {
+        QString text;
+        std::vector<quint64> values;
+        int rows() const;
+    };
+
+    void append(Chunk chunk);
+    void flush();
+
+    std::vector<Chunk> chunks;
+    std::vector<int> firstRows;    // First row of each published chunk.
+    int publishedRows = 0;
+    size_t publishedChunks = 0;    // chunks[publishedChunks..] wait for the next flush.
+    QTimer flushTimer;
+};
+
+#endif // COLLATZOUTPUTMODEL_H
@@ -0,0 +1,109 @@
+#include "collatzpackedmemo.h"
+#include "collatzmap.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Assumed growth of the typical chain length from one octave to the next (3 / log2(4/3) = 7.23).
+static constexpr quint64 kOctaveGrowth = 7;
+
+CollatzPackedMemo::CollatzPackedMemo(quint64 size)
+    : limit(qMax<quint64>(size, 2))
+    , words((limit / 2 + kPerWord) / kPerWord, 0)
+    , escapeKeys(1024, kEmptyKey)
+    , escapeLengths(1024, 0)
+{
+    // Lengths of the octave just finished: its best window, moved up by the typical growth,
+    // becomes the window of the next octave. Small octaves fit entirely with a base of 0.
+    std::vector<quint64> histogram;
+    unsigned octave = 1;
+    store(1, 1);
+    for (quint64 n = 3; n < limit; n += 2) {
+        unsigned width = bitWidth(n);
+        if (width != octave) {
+            quint64 best = 0;
+            quint64 inWindow = 0;
+            quint64 bestBase = 0;
+            for (quint64 length = 0; length < histogram.size(); ++length) {
+                inWindow += histogram[length];
+                if (length >= kEscape) {
+                    inWindow -= histogram[length - kEscape];
+                }
+                if (inWindow > best) {
+                    best = inWindow;
+                    bestBase = length >= kEscape ? length - kEscape + 1 : 0;
+                }
+            }
+            base[width] = bestBase > 0 ? bestBase + kOctaveGrowth : 0;
+            std::fill(histogram.begin(), histogram.end(), 0);
+            octave = width;
+        }
+
+        // One odd step and the halvings after it, until the value drops below n.
+        quint64 value = n;
+        quint64 length = 1;
+        do {
+            if (value > Collatz3x1::maxMultipliable) {
+                throw std::overflow_error("64-bit integer overflow during calculation");
+            }
+            value = 3 * value + 1;
+            unsigned zeros = qCountTrailingZeroBits(value);
+            value >>= zeros;
+            length += 1 + zeros;
+        } while (value >= n);
+        length += this->length(value) - 1;
+
+        store(n, length);
+        if (length >= histogram.size()) {
+            histogram.resize(length + 1, 0);
+        }
+        ++histogram[length];
+    }
+}
+
+quint64 CollatzPackedMemo::bytes() const {
+    return words.size() * sizeof(quint64) + escapeKeys.size() * sizeof(quint64)
+         + escapeLengths.size() * sizeof(quint16);
+}
+
+void CollatzPackedMemo::store(quint64 n, quint64 length) {
+    quint64 index = n >> 1;
+    quint64 offset = length - base[bitWidth(n)];
+    if (length < base[bitWidth(n)] || offset >= kEscape) {
+        insertEscape(index, length);
+        offset = kEscape;
+    }
+    words[index / kPerWord] |= offset << ((index % kPerWord) * kBits);
+}
+
+void CollatzPackedMemo::insertEscape(quint64 index, quint64 length) {
+    if ((escapeCount + 1) * 2 > escapeKeys.size()) {
+        // Keep the table at most half full, so probe sequences stay short.
+        std::vector<quint64> keys(escapeKeys.size() * 2, kEmptyKey);
+        std::vector<quint16> lengths(escapeKeys.size() * 2, 0);
+        std::swap(keys, escapeKeys);
+        std::swap(lengths, escapeLengths);
+        escapeCount = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] != kEmptyKey) {
+                insertEscape(keys[i], lengths[i]);
+            }
+        }
+    }
+    const quint64 mask = escapeKeys.size() - 1;
+    quint64 slot = ((index * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (escapeKeys[slot] != kEmptyKey) {
+        slot = (slot + 1) & mask;
+    }
+    escapeKeys[slot] = index;
+    escapeLengths[slot] = static_cast<quint16>(length);
+    ++escapeCount;
+}
+
+quint64 CollatzPackedMemo::escapedLength(quint64 index) const {
+    const quint64 mask = escapeKeys.size() - 1;
+    quint64 slot = ((index * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (escapeKeys[slot] != index) {
+        slot = (slot + 1) & mask;
+    }
+    return escapeLengths[slot];
+}
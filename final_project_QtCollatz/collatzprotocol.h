@@ -0,0 +1,75 @@
+#ifndef COLLATZPROTOCOL_H
+#define COLLATZPROTOCOL_H
+
+#include <QtGlobal>
+#include <QtEndian>
+#include <QByteArray>
+
+// Binary protocol of the query daemon. All integers are little-endian.
+//
+// Request  (13 bytes): quint32 id | quint8 op     | quint64 n
+// Response (13 bytes): quint32 id | quint8 status | quint64 value
+//
+// For OpLength the value is the chain length of n. For OpSequence it is the number
+// of values in the sequence, and that many quint64 values follow the response.
+// Requests may be pipelined: a client can send any number of them without waiting,
+// responses come back in request order.
+namespace CollatzProtocol {
+
+enum Op : quint8 {
+    OpLength   = 1,
+    OpSequence = 2
+};
+
+enum Status : quint8 {
+    StatusOk         = 0,
+    StatusOverflow   = 1,  // The chain does not fit into 64 bits.
+    StatusBadRequest = 2   // Unknown op or n == 0.
+};
+
+constexpr int kRequestSize  = 13;
+constexpr int kResponseSize = 13;
+
+struct Request {
+    quint32 id;
+    quint8 op;
+    quint64 n;
+};
+
+struct Response {
+    quint32 id;
+    quint8 status;
+    quint64 value;
+};
+
+inline void appendRequest(QByteArray &out, const Request &request) {
+    char data[kRequestSize];
+    qToLittleEndian(request.id, data);
+    data[4] = static_cast<char>(request.op);
+    qToLittleEndian(request.n, data + 5);
+    out.append(data, kRequestSize);
+}
+
+inline Request readRequest(const char *data) {
+    return { qFromLittleEndian<quint32>(data),
+             static_cast<quint8>(data[4]),
+             qFromLittleEndian<quint64>(data + 5) };
+}
+
+inline void appendResponse(QByteArray &out, const Response &response) {
+    char data[kResponseSize];
+    qToLittleEndian(response.id, data);
+    data[4] = static_cast<char>(response.status);
+    qToLittleEndian(response.value, data + 5);
+    out.append(data, kResponseSize);
+}
+
+inline Response readResponse(const char *data) {
+    return { qFromLittleEndian<quint32>(data),
+             static_cast<quint8>(data[4]),
+             qFromLittleEndian<quint64>(data + 5) };
+}
+
+} // namespace CollatzProtocol
+
+#endif // COLLATZPROTOCOL_H
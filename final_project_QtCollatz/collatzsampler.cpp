@@ -0,0 +1,239 @@
+#include "collatzsampler.h"
+#include "collatzcalculator.h"
+#include <QtConcurrent>
+#include <QFuture>
+#include <QElapsedTimer>
+#include <QList>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+
+// Trajectory arithmetic for the chains that leave 64 bits (the same choice as in the verifier).
+#if defined(__SIZEOF_INT128__)
+using WideWord = unsigned __int128;
+#else
+using WideWord = quint64;
+#endif
+
+static constexpr WideWord kMaxOddValue = (static_cast<WideWord>(~WideWord(0)) - 1) / 3;
+
+static inline unsigned trailingZeros(WideWord x) {
+#if defined(__SIZEOF_INT128__)
+    quint64 low = static_cast<quint64>(x);
+    return low != 0 ? qCountTrailingZeroBits(low)
+                    : 64 + qCountTrailingZeroBits(static_cast<quint64>(x >> 64));
+#else
+    return qCountTrailingZeroBits(x);
+#endif
+}
+
+// Chain length of start in wide arithmetic, or 0 if the trajectory leaves WideWord.
+static quint64 wideLength(quint64 start) {
+    WideWord n = start;
+    quint64 length = 1;
+    while (n != 1) {
+        if (n & 1) {
+            if (n > kMaxOddValue) {
+                return 0;
+            }
+            n = 3 * n + 1;
+            ++length;
+        }
+        unsigned zeros = trailingZeros(n);
+        n >>= zeros;
+        length += zeros;
+    }
+    return length;
+}
+
+// SplitMix64 finalizer: a bijection that spreads every input bit over the whole word.
+static inline quint64 mix(quint64 x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Offset of sample 'index' within a stratum of 'size' values. Depends only on its arguments,
+// so it does not matter which thread draws the sample.
+static inline quint64 sampleOffset(quint64 seed, quint64 stratum, quint64 index, quint64 size) {
+    return mix(mix(seed + stratum * 0x9E3779B97F4A7C15ULL) + index) % size;
+}
+
+// Stratum h of the range: the first (size % strata) strata are one value longer.
+struct Strata {
+    quint64 count;
+    quint64 width;
+    quint64 longer;
+
+    quint64 start(quint64 h) const { return h * width + qMin(h, longer); }
+    quint64 size(quint64 h) const { return width + (h < longer ? 1 : 0); }
+};
+
+struct StratumTotals {
+    quint64 count = 0;
+    quint64 sum = 0;         // Integer sums: the estimates are exact and independent of the thread count.
+    quint64 sumSquares = 0;
+};
+
+// Per-thread results of one round.
+struct RoundCounts {
+    std::vector<quint64> histogram;
+    quint64 overflowCount = 0;
+};
+
+// Worker: takes strata from the cursor and draws options->perStratum samples from each.
+// Every stratum is handled by one worker per round, so its totals need no lock.
+static RoundCounts sampleStrata(quint64 first, Strata strata, quint64 round, const CollatzSampleOptions *options,
+                                const CollatzLengthOracle *oracle, std::vector<StratumTotals> *totals,
+                                std::atomic<quint64> *nextStratum, std::atomic_bool *stopFlag) {
+    RoundCounts counts;
+    std::vector<quint64> values(options->perStratum);
+    std::vector<quint64> lengths(options->perStratum);
+    while (!stopFlag->load()) {
+        quint64 h = nextStratum->fetch_add(1, std::memory_order_relaxed);
+        if (h >= strata.count) {
+            break;
+        }
+        quint64 start = first + strata.start(h);
+        for (quint64 j = 0; j < options->perStratum; ++j) {
+            values[j] = start + sampleOffset(options->seed, h, round * options->perStratum + j, strata.size(h));
+        }
+        // Interleaved, table-backed lengths; 0 where a chain leaves 64 bits.
+        oracle->lengths(values.data(), lengths.data(), values.size());
+
+        StratumTotals &stratum = (*totals)[h];
+        for (quint64 j = 0; j < options->perStratum; ++j) {
+            quint64 length = lengths[j] != 0 ? lengths[j] : wideLength(values[j]);
+            if (length == 0) {
+                ++counts.overflowCount;
+                continue;
+            }
+            ++stratum.count;
+            stratum.sum += length;
+            stratum.sumSquares += length * length;
+            if (length >= counts.histogram.size()) {
+                counts.histogram.resize(length + 1, 0);
+            }
+            ++counts.histogram[length];
+        }
+    }
+    return counts;
+}
+
+// z such that a standard normal variable lies within +-z with the given probability.
+static double normalQuantile(double confidence) {
+    double low = 0.0;
+    double high = 10.0;
+    for (int i = 0; i < 100; ++i) {
+        double z = (low + high) / 2;
+        if (std::erf(z / std::sqrt(2.0)) < confidence) {
+            low = z;
+        } else {
+            high = z;
+        }
+    }
+    return (low + high) / 2;
+}
+
+// Smallest length whose cumulative count reaches the fraction p of all samples.
+static quint64 histogramQuantile(const std::vector<quint64> &histogram, quint64 samples, double p) {
+    double target = qBound(0.0, p, 1.0) * samples;
+    quint64 cumulative = 0;
+    for (quint64 length = 0; length < histogram.size(); ++length) {
+        cumulative += histogram[length];
+        if (cumulative > 0 && cumulative >= target) {
+            return length;
+        }
+    }
+    return histogram.empty() ? 0 : histogram.size() - 1;
+}
+
+CollatzSampleResult CollatzSampler::sample(quint64 first, quint64 last, const CollatzSampleOptions &options,
+                                           std::atomic_bool &stopFlag) {
+    QElapsedTimer timer;
+    timer.start();
+
+    CollatzSampleResult result { 0, 0, 0.0, 0.0, 0.0, {}, {}, 0, false, 0 };
+    first = qMax<quint64>(first, 1);
+    if (first > last) {
+        result.timeMs = timer.elapsed();
+        return result;
+    }
+
+    CollatzSampleOptions settings = options;
+    settings.perStratum = qMax<quint64>(settings.perStratum, 2);  // A stratum variance needs two samples.
+    quint64 rangeSize = last - first + 1;  // At most 2^64 - 1, since first >= 1.
+    Strata strata;
+    strata.count = qBound<quint64>(1, settings.strata, rangeSize);
+    strata.width = rangeSize / strata.count;
+    strata.longer = rangeSize % strata.count;
+
+    CollatzLengthOracle oracle(settings.memoSize);
+    std::vector<StratumTotals> totals(strata.count);
+    const double z = normalQuantile(qBound(0.5, settings.confidence, 0.999999));
+    const quint64 roundSize = strata.count * settings.perStratum;
+    int numThreads = qMax(1, settings.numThreads);
+
+    while (!stopFlag.load() && (result.rounds == 0 || result.samples + roundSize <= settings.maxSamples)) {
+        std::atomic<quint64> nextStratum { 0 };
+        QList<QFuture<RoundCounts>> futures;
+        for (int i = 0; i < numThreads; ++i) {
+            futures.append(QtConcurrent::run(sampleStrata, first, strata, result.rounds, &settings, &oracle, &totals,
+                                             &nextStratum, &stopFlag));
+        }
+        for (auto &future : futures) {
+            future.waitForFinished();
+            RoundCounts counts = future.result();
+            if (counts.histogram.size() > result.histogram.size()) {
+                result.histogram.resize(counts.histogram.size(), 0);
+            }
+            for (size_t length = 0; length < counts.histogram.size(); ++length) {
+                result.histogram[length] += counts.histogram[length];
+            }
+            result.overflowCount += counts.overflowCount;
+        }
+        ++result.rounds;
+
+        // Stratified estimates: every stratum weighs by its share of the range.
+        double mean = 0.0;
+        double meanSquares = 0.0;
+        double variance = 0.0;
+        double covered = 0.0;
+        result.samples = 0;
+        for (quint64 h = 0; h < strata.count; ++h) {
+            const StratumTotals &stratum = totals[h];
+            result.samples += stratum.count;
+            if (stratum.count < 2) {
+                continue;  // Every sample overflowed, or the round was cancelled.
+            }
+            double weight = static_cast<double>(strata.size(h)) / rangeSize;
+            double n = static_cast<double>(stratum.count);
+            double stratumMean = stratum.sum / n;
+            double stratumVariance = qMax(0.0, (stratum.sumSquares - stratum.sum * stratumMean) / (n - 1));
+            mean += weight * stratumMean;
+            meanSquares += weight * stratum.sumSquares / n;
+            variance += weight * weight * stratumVariance / n;
+            covered += weight;
+        }
+        if (covered > 0) {
+            result.mean = mean / covered;
+            result.deviation = std::sqrt(qMax(0.0, meanSquares / covered - result.mean * result.mean));
+            result.meanError = z * std::sqrt(variance) / covered;
+        }
+        if (result.meanError <= settings.precision && covered > 0) {
+            result.converged = true;
+            break;
+        }
+    }
+
+    // Quantiles with the order statistic interval p +- z * sqrt(p (1 - p) / n).
+    for (double p : { 0.5, 0.9, 0.99, 0.999, 0.9999 }) {
+        double spread = z * std::sqrt(p * (1 - p) / qMax<quint64>(result.samples, 1));
+        result.quantiles.push_back({ p, histogramQuantile(result.histogram, result.samples, p),
+                                     histogramQuantile(result.histogram, result.samples, p - spread),
+                                     histogramQuantile(result.histogram, result.samples, p + spread) });
+    }
+    result.converged = result.converged && !stopFlag.load();
+    result.timeMs = timer.elapsed();
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef COLLATZSAMPLER_H
+#define COLLATZSAMPLER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+// Parameters of a sampling run.
+struct CollatzSampleOptions {
+    int numThreads = 1;             // Number of worker threads.
+    quint64 seed = 1;               // Same seed and options: same samples and estimates, for any thread count.
+    quint64 strata = 1024;          // Equal-width slices of the range; every round samples each of them.
+    quint64 perStratum = 16;        // Samples per stratum and round.
+    quint64 maxSamples = 10000000;  // Upper bound on the samples taken.
+    double precision = 0.1;         // Stop once the confidence interval of the mean is at most +-precision steps.
+    double confidence = 0.95;       // Coverage of the confidence intervals.
+    quint64 memoSize = 1 << 22;     // Chain length table that finishes the chains once they drop below it.
+};
+
+// Estimate of a quantile of the chain length, with a distribution-free confidence interval.
+struct CollatzQuantile {
+    double probability;
+    quint64 value;
+    quint64 low;
+    quint64 high;
+};
+
+struct CollatzSampleResult {
+    quint64 samples;                      // Chain lengths measured.
+    quint64 rounds;
+    double mean;                          // Stratified estimate of the mean chain length.
+    double meanError;                     // Half-width of its confidence interval.
+    double deviation;                     // Standard deviation of the chain length.
+    std::vector<CollatzQuantile> quantiles;
+    std::vector<quint64> histogram;       // histogram[length] = samples with that chain length.
+    quint64 overflowCount;                // Samples whose trajectory left the wide word range (not counted).
+    bool converged;                       // The requested precision was reached.
+    qint64 timeMs;
+};
+
+// Estimates the distribution of chain lengths over ranges far too large to scan.
+//
+// The range is cut into equal strata and every round draws the same number of uniform
+// samples from each of them, so all parts of the range are represented and the variance
+// of the mean is that within the strata only. Positions come from a counter-based random
+// generator keyed by (seed, stratum, sample): a run is reproducible and independent of
+// the thread count. Chains are followed in 128-bit arithmetic where the compiler provides
+// it, so any 64-bit start value works.
+class CollatzSampler {
+public:
+    // Samples [first, last] until the precision is reached, maxSamples are taken or stopFlag is set.
+    static CollatzSampleResult sample(quint64 first, quint64 last, const CollatzSampleOptions &options,
+                                      std::atomic_bool &stopFlag);
+};
+
+#endif // COLLATZSAMPLER_H
@@ -0,0 +1,117 @@
+#include "collatzserver.h"
+#include "collatzprotocol.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+
+using namespace CollatzProtocol;
+
+// Number of cached answers (a power of two).
+static constexpr size_t kCacheSize = 1 << 16;
+
+CollatzServer::CollatzServer(quint64 memoSize, QObject *parent)
+    : QObject(parent)
+    , server(new QLocalServer(this))
+    , oracle(memoSize)
+    , cache(kCacheSize, CacheEntry { 0, 0 })
+{
+    connect(server, &QLocalServer::newConnection, this, &CollatzServer::onNewConnection);
+}
+
+bool CollatzServer::listen(const QString &name)
+{
+    QLocalServer::removeServer(name);
+    return server->listen(name);
+}
+
+QString CollatzServer::errorString() const
+{
+    return server->errorString();
+}
+
+void CollatzServer::onNewConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        pending.insert(socket, QByteArray());
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            processRequests(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            pending.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+CollatzServer::CacheEntry &CollatzServer::cacheSlot(quint64 n)
+{
+    // Fibonacci hashing: consecutive values land in different slots.
+    return cache[(n * 0x9E3779B97F4A7C15ULL) >> 48 & (kCacheSize - 1)];
+}
+
+void CollatzServer::processRequests(QLocalSocket *socket)
+{
+    QByteArray &buffer = pending[socket];
+    buffer.append(socket->readAll());
+    int count = buffer.size() / kRequestSize;
+    if (count == 0) {
+        return;
+    }
+
+    // Pass 1: decode the batch and answer what is already known.
+    std::vector<Request> requests(count);
+    std::vector<Response> responses(count);
+    missValues.clear();
+    missIndices.clear();
+    for (int i = 0; i < count; ++i) {
+        Request request = readRequest(buffer.constData() + i * kRequestSize);
+        requests[i] = request;
+        responses[i] = { request.id, StatusOk, 0 };
+        if (request.n == 0 || (request.op != OpLength && request.op != OpSequence)) {
+            responses[i].status = StatusBadRequest;
+        } else if (request.op == OpLength) {
+            const CacheEntry &entry = cacheSlot(request.n);
+            if (entry.n == request.n) {
+                responses[i].value = entry.length;
+            } else {
+                missValues.push_back(request.n);
+                missIndices.push_back(i);
+            }
+        }
+    }
+    buffer.remove(0, count * kRequestSize);
+
+    // Pass 2: all cache misses in one kernel call.
+    missLengths.resize(missValues.size());
+    oracle.lengths(missValues.data(), missLengths.data(), missValues.size());
+    for (size_t j = 0; j < missValues.size(); ++j) {
+        Response &response = responses[missIndices[j]];
+        if (missLengths[j] == 0) {
+            response.status = StatusOverflow;
+        } else {
+            response.value = missLengths[j];
+            cacheSlot(missValues[j]) = { missValues[j], missLengths[j] };
+        }
+    }
+
+    // Pass 3: encode all responses in request order and send them with one write.
+    QByteArray out;
+    out.reserve(count * kResponseSize);
+    for (int i = 0; i < count; ++i) {
+        if (requests[i].op == OpSequence && responses[i].status == StatusOk) {
+            std::vector<quint64> sequence = CollatzLengthOracle::sequence(requests[i].n);
+            if (sequence.empty()) {
+                appendResponse(out, { responses[i].id, StatusOverflow, 0 });
+                continue;
+            }
+            appendResponse(out, { responses[i].id, StatusOk, sequence.size() });
+            for (quint64 value : sequence) {
+                char data[sizeof(quint64)];
+                qToLittleEndian(value, data);
+                out.append(data, sizeof(data));
+            }
+        } else {
+            appendResponse(out, responses[i]);
+        }
+    }
+    socket->write(out);
+}
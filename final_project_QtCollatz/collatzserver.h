@@ -0,0 +1,51 @@
+#ifndef COLLATZSERVER_H
+#define COLLATZSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QString>
+#include <vector>
+#include "collatzcalculator.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+// Query daemon: answers chain length and sequence requests over a local socket
+// (a Unix domain socket on Unix, a named pipe on Windows), see collatzprotocol.h.
+//
+// All requests that arrived on a connection are handled as one batch: answers for
+// recently seen values come from a cache, the rest go through a single
+// CollatzLengthOracle::lengths() call, and all responses are sent with one write.
+class CollatzServer : public QObject
+{
+public:
+    explicit CollatzServer(quint64 memoSize, QObject *parent = nullptr);
+
+    // Starts listening; a stale socket left by a crashed daemon is removed first.
+    bool listen(const QString &name);
+    QString errorString() const;
+
+private:
+    // Cached answer; n == 0 marks an empty slot.
+    struct CacheEntry {
+        quint64 n;
+        quint64 length;
+    };
+
+    void onNewConnection();
+    void processRequests(QLocalSocket *socket);
+    CacheEntry &cacheSlot(quint64 n);
+
+    QLocalServer *server;
+    CollatzLengthOracle oracle;
+    std::vector<CacheEntry> cache;               // Direct-mapped: a new answer replaces the old one in its slot.
+    QHash<QLocalSocket *, QByteArray> pending;   // Incomplete requests per connection.
+
+    // Scratch buffers reused by every batch.
+    std::vector<quint64> missValues;
+    std::vector<quint64> missLengths;
+    std::vector<int> missIndices;
+};
+
+#endif // COLLATZSERVER_H
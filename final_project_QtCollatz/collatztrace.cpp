@@ -0,0 +1,111 @@
+#include "collatztrace.h"
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+
+CollatzTraceBuffer::CollatzTraceBuffer(size_t capacity, int thread)
+    : events(capacity)
+    , mask(capacity - 1)
+    , thread(thread)
+    , owner(std::this_thread::get_id())
+{
+}
+
+CollatzTrace::CollatzTrace(size_t eventsPerThread)
+    : capacity(1)
+    , startTicks(CollatzTraceBuffer::now())
+    , startTime(std::chrono::steady_clock::now())
+{
+    while (capacity < eventsPerThread) {
+        capacity <<= 1;
+    }
+}
+
+CollatzTraceBuffer *CollatzTrace::threadBuffer() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::thread::id self = std::this_thread::get_id();
+    for (const auto &buffer : buffers) {
+        if (buffer->owner == self) {
+            return buffer.get();
+        }
+    }
+    buffers.push_back(std::make_unique<CollatzTraceBuffer>(capacity, static_cast<int>(buffers.size()) + 1));
+    return buffers.back().get();
+}
+
+quint64 CollatzTrace::droppedEvents() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return droppedLocked();
+}
+
+quint64 CollatzTrace::droppedLocked() const {
+    quint64 dropped = 0;
+    for (const auto &buffer : buffers) {
+        dropped += buffer->recorded - qMin<quint64>(buffer->recorded, capacity);
+    }
+    return dropped;
+}
+
+static const char *eventName(CollatzTraceKind kind) {
+    switch (kind) {
+    case CollatzTraceKind::Block:     return "block";
+    case CollatzTraceKind::Claim:     return "claim";
+    case CollatzTraceKind::Cancel:    return "cancel";
+    case CollatzTraceKind::MemoBuild: return "memo build";
+    }
+    return "";
+}
+
+bool CollatzTrace::writeChromeJson(const QString &path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    // Ticks per microsecond, from the counter and the steady clock over the lifetime of
+    // the trace. A short trace is stretched a little so that the ratio is accurate.
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    if (elapsed < std::chrono::milliseconds(10)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+    }
+    quint64 ticks = CollatzTraceBuffer::now() - startTicks;
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+    double ticksPerMicro = ticks / micros;
+    auto micro = [&](quint64 at) {
+        return QString::number((at - startTicks) / ticksPerMicro, 'f', 3);
+    };
+
+    std::lock_guard<std::mutex> lock(mutex);
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CollatzSearch\"}}";
+    for (const auto &buffer : buffers) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread
+            << ",\"args\":{\"name\":\"thread " << buffer->thread << "\"}}";
+
+        // Oldest surviving event first.
+        quint64 count = qMin<quint64>(buffer->recorded, capacity);
+        for (quint64 i = buffer->recorded - count; i < buffer->recorded; ++i) {
+            const CollatzTraceEvent &event = buffer->events[static_cast<size_t>(i) & buffer->mask];
+            out << ",\n{\"name\":\"" << eventName(event.kind) << "\",\"cat\":\"collatz\",\"pid\":1,\"tid\":"
+                << buffer->thread << ",\"ts\":" << micro(event.begin);
+            bool instant = event.kind == CollatzTraceKind::Claim || event.kind == CollatzTraceKind::Cancel;
+            if (!instant) {
+                out << ",\"ph\":\"X\",\"dur\":" << QString::number((event.end - event.begin) / ticksPerMicro, 'f', 3);
+            } else {
+                out << ",\"ph\":\"i\",\"s\":\"t\"";
+            }
+            out << ",\"args\":{\"first\":" << event.first << ",\"last\":" << event.last;
+            if (event.kind == CollatzTraceKind::Block) {
+                out << ",\"values\":" << (event.last - event.first + 1) << ",\"memoHits\":" << event.memoHits;
+            }
+            if (event.cpu != CollatzTraceBuffer::kNoCpu) {
+                out << ",\"cpu\":" << event.cpu;
+            }
+            out << "}}";
+        }
+    }
+    out << "\n],\"otherData\":{\"droppedEvents\":" << droppedLocked() << "}}\n";
+    out.flush();
+    return file.error() == QFileDevice::NoError;
+}
@@ -0,0 +1,123 @@
+#ifndef COLLATZTRACE_H
+#define COLLATZTRACE_H
+
+#include <QtGlobal>
+#include <QString>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define COLLATZ_TRACE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COLLATZ_TRACE_TSC 1
+#endif
+
+// Timeline tracing is compiled in only with -DCOLLATZ_TRACING=ON (CMake option). Without it
+// every recording call sits behind `if constexpr (kCollatzTracing)` and generates no code.
+#ifdef COLLATZ_TRACING
+inline constexpr bool kCollatzTracing = true;
+#else
+inline constexpr bool kCollatzTracing = false;
+#endif
+
+enum class CollatzTraceKind : quint32 {
+    Block,      // One block (or static chunk) of the range.
+    Claim,      // A worker took the next block from the shared cursor (instant).
+    Cancel,     // A worker saw the stop flag (instant).
+    MemoBuild   // Building the memo table before the workers start.
+};
+
+struct CollatzTraceEvent {
+    quint64 begin;           // Timestamp counter ticks.
+    quint64 end;             // Equal to begin for instant events.
+    quint64 first;           // Range covered (Block, MemoBuild), block start (Claim), current value (Cancel).
+    quint64 last;
+    quint64 memoHits;        // Chains finished from the memo table.
+    quint32 cpu;             // Logical CPU at 'begin', kNoCpu if unknown.
+    CollatzTraceKind kind;
+};
+
+// Events of one thread: a fixed ring that overwrites its oldest events when full.
+// Only the owning thread writes; the trace is read after the workers have finished.
+class CollatzTraceBuffer {
+public:
+    static constexpr quint32 kNoCpu = ~0U;
+
+    CollatzTraceBuffer(size_t capacity, int thread);
+
+    // Current timestamp counter (TSC where available, steady clock nanoseconds otherwise).
+    static quint64 now() {
+#ifdef COLLATZ_TRACE_TSC
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    // Timestamp and the logical CPU that read it (one rdtscp instruction on x86).
+    static quint64 now(quint32 &cpu) {
+#ifdef COLLATZ_TRACE_TSC
+        unsigned aux = 0;
+        quint64 ticks = __rdtscp(&aux);
+        cpu = aux & 0xFFF;  // Linux and Windows keep the CPU number in the low 12 bits.
+        return ticks;
+#else
+        cpu = kNoCpu;
+        return now();
+#endif
+    }
+
+    void record(const CollatzTraceEvent &event) {
+        events[static_cast<size_t>(recorded) & mask] = event;
+        ++recorded;
+    }
+
+    void instant(CollatzTraceKind kind, quint64 value) {
+        quint32 cpu;
+        quint64 ticks = now(cpu);
+        record({ ticks, ticks, value, value, 0, cpu, kind });
+    }
+
+private:
+    friend class CollatzTrace;
+
+    std::vector<CollatzTraceEvent> events;
+    size_t mask;
+    quint64 recorded = 0;
+    int thread;
+    std::thread::id owner;
+};
+
+// Records the timeline of calculations that get it through CollatzOptions::trace and writes
+// it as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev): one track per worker
+// thread with its blocks, block claims and cancellations, plus the memo table build.
+class CollatzTrace {
+public:
+    // eventsPerThread is rounded up to a power of two.
+    explicit CollatzTrace(size_t eventsPerThread = 1 << 16);
+
+    // Buffer of the calling thread, created on first use. Workers call it once per task.
+    CollatzTraceBuffer *threadBuffer();
+
+    // Events lost because a ring was full.
+    quint64 droppedEvents() const;
+
+    // Writes all recorded events. The traced calculations must have finished.
+    bool writeChromeJson(const QString &path) const;
+
+private:
+    size_t capacity;
+    quint64 startTicks;
+    std::chrono::steady_clock::time_point startTime;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<CollatzTraceBuffer>> buffers;
+
+    quint64 droppedLocked() const;
+};
+
+#endif // COLLATZTRACE_H
@@ -0,0 +1,216 @@
+#include "collatzverifier.h"
+#include <QtConcurrent>
+#include <QFuture>
+#include <QElapsedTimer>
+#include <QList>
+#include <QtAlgorithms>
+#include <algorithm>
+
+// Trajectory arithmetic. Values can exceed their 64-bit start by a large factor,
+// so the wide type is used wherever the compiler has one.
+#if defined(__SIZEOF_INT128__)
+using WideWord = unsigned __int128;
+#else
+using WideWord = quint64;
+#endif
+
+static constexpr WideWord kWideMax = static_cast<WideWord>(~WideWord(0));
+static constexpr WideWord kMaxOddValue = (kWideMax - 1) / 3;
+
+// Sieve residue classes per work item (each class is 2^k consecutive values).
+static constexpr quint64 kClassesPerTask = 64;
+
+static inline unsigned trailingZeros(WideWord x) {
+#if defined(__SIZEOF_INT128__)
+    quint64 low = static_cast<quint64>(x);
+    return low != 0 ? qCountTrailingZeroBits(low)
+                    : 64 + qCountTrailingZeroBits(static_cast<quint64>(x >> 64));
+#else
+    return qCountTrailingZeroBits(x);
+#endif
+}
+
+// Residue r mod 2^k that does not provably drop within k steps.
+// For n = 2^k * m + r: T^k(n) = power3 * m + tail.
+struct SieveEntry {
+    quint64 residue;
+    quint64 power3;   // 3^a, a = number of odd steps among the first k.
+    quint64 tail;     // T^k(r).
+    quint64 steps;    // Steps of the plain 3n+1 map covered by the jump (k + a).
+    quint64 maxClass; // Largest m for which the jump fits into WideWord.
+};
+
+// Builds the list of surviving residues mod 2^bits.
+//
+// After j steps, n = r (mod 2^j) gives T^j(n) = (3^a * n + b) / 2^j. Once 3^a < 2^j this is
+// below n for every n > b / (2^j - 3^a); if that holds for all n >= 2^bits the class is
+// dropped. Values below 2^bits are iterated directly, so they need no such guarantee.
+static std::vector<SieveEntry> buildSieve(unsigned bits) {
+    std::vector<SieveEntry> survivors;
+    const quint64 modulus = 1ULL << bits;
+    for (quint64 r = 1; r < modulus; r += 2) {
+        quint64 x = r;       // T^j(r)
+        quint64 power3 = 1;  // 3^a
+        quint64 b = 0;
+        quint64 oddSteps = 0;
+        bool drops = false;
+        for (unsigned j = 1; j <= bits; ++j) {
+            if (x & 1) {
+                x = (3 * x + 1) >> 1;
+                b = 3 * b + (1ULL << (j - 1));
+                power3 *= 3;
+                ++oddSteps;
+            } else {
+                x >>= 1;
+            }
+            quint64 twoPowJ = 1ULL << j;
+            if (power3 < twoPowJ && b < modulus * (twoPowJ - power3)) {
+                drops = true;
+                break;
+            }
+        }
+        if (!drops) {
+            WideWord maxClass = (kWideMax - x) / power3;
+            survivors.push_back({ r, power3, x, bits + oddSteps,
+                                  maxClass > ~0ULL ? ~0ULL : static_cast<quint64>(maxClass) });
+        }
+    }
+    return survivors;
+}
+
+// Per-thread totals.
+struct VerifyCounts {
+    quint64 iterated = 0;
+    quint64 exceededCount = 0;
+    std::vector<quint64> exceeded;
+    quint64 overflowCount = 0;
+    std::vector<quint64> overflowed;
+
+    void merge(const VerifyCounts &other) {
+        iterated += other.iterated;
+        exceededCount += other.exceededCount;
+        overflowCount += other.overflowCount;
+        exceeded.insert(exceeded.end(), other.exceeded.begin(), other.exceeded.end());
+        overflowed.insert(overflowed.end(), other.overflowed.begin(), other.overflowed.end());
+    }
+};
+
+static void report(std::vector<quint64> &list, quint64 &count, quint64 n) {
+    ++count;
+    if (list.size() < CollatzVerifier::kMaxReported) {
+        list.push_back(n);
+    }
+}
+
+// Iterates x (the value reached from 'start' after 'steps' steps) until it drops below start.
+static inline void finishTrajectory(quint64 start, WideWord x, quint64 steps, quint64 maxSteps, VerifyCounts &counts) {
+    ++counts.iterated;
+    while (x >= start) {
+        if (steps >= maxSteps) {
+            report(counts.exceeded, counts.exceededCount, start);
+            return;
+        }
+        if (x & 1) {
+            if (x > kMaxOddValue) {
+                report(counts.overflowed, counts.overflowCount, start);
+                return;
+            }
+            x = 3 * x + 1;
+            ++steps;
+        }
+        unsigned zeros = trailingZeros(x);
+        x >>= zeros;
+        steps += zeros;
+    }
+}
+
+// Worker: takes kClassesPerTask classes of 2^k values at a time until the range is done.
+static VerifyCounts verifyClasses(quint64 first, quint64 last, quint64 firstClass, quint64 classCount,
+                                  const std::vector<SieveEntry> *sieve, unsigned bits, quint64 maxSteps,
+                                  std::atomic<quint64> *nextClass, std::atomic_bool *stopFlag) {
+    VerifyCounts counts;
+    while (!stopFlag->load()) {
+        quint64 begin = nextClass->fetch_add(kClassesPerTask, std::memory_order_relaxed);
+        if (begin >= classCount) {
+            break;
+        }
+        quint64 end = qMin(classCount, begin + kClassesPerTask);
+        for (quint64 c = begin; c < end; ++c) {
+            quint64 m = firstClass + c;
+            quint64 base = m << bits;
+            bool edge = base < first || last - base < (1ULL << bits);
+            if (m == 0) {
+                // Below 2^k the sieve guarantees nothing: iterate every value directly.
+                quint64 top = qMin(last, (1ULL << bits) - 1);
+                for (quint64 n = qMax<quint64>(first, 2); n <= top; ++n) {
+                    finishTrajectory(n, n, 0, maxSteps, counts);
+                }
+                continue;
+            }
+            for (const SieveEntry &entry : *sieve) {
+                quint64 n = base + entry.residue;
+                if (edge && (n < first || n > last)) {
+                    continue;
+                }
+                if (m > entry.maxClass) {
+                    report(counts.overflowed, counts.overflowCount, n);
+                    continue;
+                }
+                WideWord x = static_cast<WideWord>(entry.power3) * m + entry.tail;
+                finishTrajectory(n, x, entry.steps, maxSteps, counts);
+            }
+        }
+    }
+    return counts;
+}
+
+CollatzVerifyResult CollatzVerifier::verify(quint64 first, quint64 last, const CollatzVerifyOptions &options,
+                                            std::atomic_bool &stopFlag) {
+    QElapsedTimer timer;
+    timer.start();
+
+    CollatzVerifyResult result { 0, 0, 0, {}, 0, {}, true, 0 };
+    first = qMax<quint64>(first, 1);
+    if (first > last) {
+        result.timeMs = timer.elapsed();
+        return result;
+    }
+
+    unsigned bits = qBound(1U, options.sieveBits, 24U);
+    std::vector<SieveEntry> sieve = buildSieve(bits);
+
+    quint64 firstClass = first >> bits;
+    quint64 classCount = (last >> bits) - firstClass + 1;
+    std::atomic<quint64> nextClass { 0 };
+    int numThreads = qMax(1, options.numThreads);
+
+    QList<QFuture<VerifyCounts>> futures;
+    for (int i = 0; i < numThreads; ++i) {
+        futures.append(QtConcurrent::run(verifyClasses, first, last, firstClass, classCount, &sieve, bits,
+                                         options.maxSteps, &nextClass, &stopFlag));
+    }
+    VerifyCounts total;
+    for (auto &future : futures) {
+        future.waitForFinished();
+        total.merge(future.result());
+    }
+
+    std::sort(total.exceeded.begin(), total.exceeded.end());
+    std::sort(total.overflowed.begin(), total.overflowed.end());
+    if (total.exceeded.size() > kMaxReported) {
+        total.exceeded.resize(kMaxReported);
+    }
+    if (total.overflowed.size() > kMaxReported) {
+        total.overflowed.resize(kMaxReported);
+    }
+
+    result.complete = !stopFlag.load();
+    result.checked = result.complete ? last - first + 1 : 0;
+    result.iterated = total.iterated;
+    result.exceededCount = total.exceededCount;
+    result.exceeded = std::move(total.exceeded);
+    result.overflowCount = total.overflowCount;
+    result.overflowed = std::move(total.overflowed);
+    result.timeMs = timer.elapsed();
+    return result;
+}
@@ -0,0 +1,44 @@
+#ifndef COLLATZVERIFIER_H
+#define COLLATZVERIFIER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+// Parameters of a convergence verification run.
+struct CollatzVerifyOptions {
+    int numThreads = 1;          // Number of worker threads.
+    unsigned sieveBits = 20;     // k: residues mod 2^k that provably drop within k steps are skipped (1..24).
+    quint64 maxSteps = 100000;   // Step bound: trajectories still above their start after it are reported.
+};
+
+struct CollatzVerifyResult {
+    quint64 checked;                  // Values of the range that were covered.
+    quint64 iterated;                 // Values that survived the sieve and were actually iterated.
+    quint64 exceededCount;            // Values that did not drop below their start within maxSteps steps.
+    std::vector<quint64> exceeded;    // The first of them (at most kMaxReported).
+    quint64 overflowCount;            // Values whose trajectory left the word range.
+    std::vector<quint64> overflowed;  // The first of them (at most kMaxReported).
+    bool complete;                    // False if the run was stopped early.
+    qint64 timeMs;                    // Total time in milliseconds.
+};
+
+// Verifies that every n in a range eventually drops below itself (finite stopping time),
+// which is all a convergence sweep needs, instead of following each chain down to 1.
+//
+// Works with the Terras map T(n) = n / 2 or (3n + 1) / 2. For n = 2^k * m + r the first k
+// steps depend only on r, so T^k(n) = 3^a * m + T^k(r), where a is the number of odd steps.
+// Residues whose partial trajectory already has 3^a < 2^j after some j <= k drop below n
+// for all large n and are skipped (even numbers and n = 1 mod 4 are the simplest cases).
+// The survivors jump k steps at once and are then iterated until they fall below their start.
+// Trajectories are computed with 128-bit arithmetic where the compiler provides it.
+class CollatzVerifier {
+public:
+    static constexpr size_t kMaxReported = 1000;
+
+    // Verifies [first, last]. Values below 2^k are iterated directly.
+    static CollatzVerifyResult verify(quint64 first, quint64 last, const CollatzVerifyOptions &options,
+                                      std::atomic_bool &stopFlag);
+};
+
+#endif // COLLATZVERIFIER_H
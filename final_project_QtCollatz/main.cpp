@@ -1,8 +1,15 @@
 #include "mainwindow.h"
+#include "collatzcli.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // Command-line modes (see --help) do not need any widgets.
+    if (CollatzCli::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return CollatzCli::run(app);
+    }
+
     QApplication app(argc, argv);
     MainWindow window;
     window.setWindowTitle("Коллатц Пошук");
@@ -3,7 +3,8 @@
 #include <QPushButton>
 #include <QSlider>
 #include <QSpinBox>
-#include <QTextEdit>
+#include <QListView>
+#include <QScrollBar>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -21,12 +22,13 @@ MainWindow::MainWindow(QWidget *parent)
     setCentralWidget(centralWidget);
     QVBoxLayout *mainLayout = new QVBoxLayout(centralWidget);
 
-    // --- Row with "Start", "Stop", "Test", "Exit" ---
+    // --- Row with "Start", "Stop", "Test", "Autotune", "Exit" ---
     QHBoxLayout *buttonLayout = new QHBoxLayout();
-    startButton = new QPushButton("Start", this);
-    stopButton  = new QPushButton("Stop",  this);
-    testButton  = new QPushButton("Test",  this);
-    exitButton  = new QPushButton("Exit",  this);
+    startButton    = new QPushButton("Start",    this);
+    stopButton     = new QPushButton("Stop",     this);
+    testButton     = new QPushButton("Test",     this);
+    autotuneButton = new QPushButton("Autotune", this);
+    exitButton     = new QPushButton("Exit",     this);
 
     // By default, "Stop" is disabled
     stopButton->setEnabled(false);
@@ -34,6 +36,7 @@ MainWindow::MainWindow(QWidget *parent)
     buttonLayout->addWidget(startButton);
     buttonLayout->addWidget(stopButton);
     buttonLayout->addWidget(testButton);
+    buttonLayout->addWidget(autotuneButton);
     buttonLayout->addWidget(exitButton);
 
     // --- Slider for threads count ---
@@ -59,33 +62,49 @@ MainWindow::MainWindow(QWidget *parent)
     spinBoxLayout->addWidget(spinBoxLabel);
     spinBoxLayout->addWidget(limitSpinBox);
 
-    // --- Read-only text output ---
-    outputTextEdit = new QTextEdit(this);
-    outputTextEdit->setReadOnly(true);
+    // --- Read-only output list: rows are formatted only while visible ---
+    outputModel = new CollatzOutputModel(this);
+    outputView = new QListView(this);
+    outputView->setModel(outputModel);
+    outputView->setUniformItemSizes(true);
+    outputView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    outputView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+
+    // Follow new output like a log, unless the user scrolled up to read
+    connect(outputModel, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar *bar = outputView->verticalScrollBar();
+        followOutput = bar->value() == bar->maximum();
+    });
+    connect(outputModel, &QAbstractItemModel::rowsInserted, this, [this]() {
+        if (followOutput) {
+            outputView->scrollToBottom();
+        }
+    });
 
     // Add everything to the main layout
     mainLayout->addLayout(buttonLayout);
     mainLayout->addLayout(sliderLayout);
     mainLayout->addLayout(spinBoxLayout);
-    mainLayout->addWidget(outputTextEdit);
+    mainLayout->addWidget(outputView);
 
     // Initialize the calculation watcher
     calcWatcher = new QFutureWatcher<CollatzResult>(this);
     connect(calcWatcher, &QFutureWatcher<CollatzResult>::finished, this, [this]() {
         try {
             CollatzResult result = calcWatcher->result();
-            outputTextEdit->append("----- Результати обчислень -----");
-            outputTextEdit->append(QString("Верхня межа: %1").arg(currentLimit));
-            outputTextEdit->append(QString("Використано потоків: %1").arg(currentNumThreads));
+            outputModel->appendLine("----- Результати обчислень -----");
+            outputModel->appendLine(QString("Верхня межа: %1").arg(currentLimit));
+            outputModel->appendLine(QString("Використано потоків: %1").arg(currentNumThreads));
+            outputModel->appendLine(QString("Ядро: %1").arg(CollatzCalculator::kernelName(tunedOptions.kernel)));
             if (stopFlag.load()) {
-                outputTextEdit->append("Обчислення перервано користувачем.");
+                outputModel->appendLine("Обчислення перервано користувачем.");
             } else {
-                outputTextEdit->append(QString("Найдовший ланцюг у діапазоні: %1")
+                outputModel->appendLine(QString("Найдовший ланцюг у діапазоні: %1")
                                            .arg(result.bestNumber));
-                outputTextEdit->append(QString("Довжина ланцюга: %1").arg(result.bestLength));
-                outputTextEdit->append(QString("Час обчислень: %1 мс").arg(result.timeMs));
+                outputModel->appendLine(QString("Довжина ланцюга: %1").arg(result.bestLength));
+                outputModel->appendLine(QString("Час обчислень: %1 мс").arg(result.timeMs));
             }
-            outputTextEdit->append("----- Кінець обчислень -----");
+            outputModel->appendLine("----- Кінець обчислень -----");
         }
         catch (const QUnhandledException &ex) {
             try {
@@ -93,22 +112,42 @@ MainWindow::MainWindow(QWidget *parent)
                 // https://stackoverflow.com/questions/76063090/how-to-propagate-exceptions-to-the-main-thread-from-a-qtconcurrentrun-with-pro
                 std::rethrow_exception(ex.exception());
             } catch (const std::exception &e) {
-                outputTextEdit->append(QString("Error: %1").arg(e.what()));
+                outputModel->appendLine(QString("Error: %1").arg(e.what()));
             } catch (...) {
-                outputTextEdit->append(QString("Unknown exception caught in QUnhandledException"));
+                outputModel->appendLine(QString("Unknown exception caught in QUnhandledException"));
             }
         }
         catch (const std::exception &e) {
-            outputTextEdit->append(QString("Error: %1").arg(e.what()));
+            outputModel->appendLine(QString("Error: %1").arg(e.what()));
+        }
+        resetUI();
+    });
+
+    // Initialize the calibration watcher
+    tuneWatcher = new QFutureWatcher<CollatzProfile>(this);
+    connect(tuneWatcher, &QFutureWatcher<CollatzProfile>::finished, this, [this]() {
+        if (stopFlag.load()) {
+            outputModel->appendLine("Калібрування перервано користувачем.");
+        } else {
+            CollatzProfile profile = tuneWatcher->result();
+            CollatzAutotuner::saveProfile(profile);
+            applyProfile(profile);
+            outputModel->appendLine(QString("Час калібрування: %1 мс").arg(profile.calibrationMs));
         }
         resetUI();
     });
 
+    // A saved profile for this machine makes calibration unnecessary on later runs
+    if (std::optional<CollatzProfile> profile = CollatzAutotuner::loadProfile()) {
+        applyProfile(*profile);
+    }
+
     // Connect signals and slots
     connect(exitButton,  &QPushButton::clicked, this, &MainWindow::close);
     connect(startButton, &QPushButton::clicked, this, &MainWindow::onStartClicked);
     connect(stopButton,  &QPushButton::clicked, this, &MainWindow::onStopClicked);
     connect(testButton,  &QPushButton::clicked, this, &MainWindow::onTestClicked);
+    connect(autotuneButton, &QPushButton::clicked, this, &MainWindow::onAutotuneClicked);
 }
 
 MainWindow::~MainWindow()
@@ -119,16 +158,20 @@ MainWindow::~MainWindow()
         calcWatcher->cancel();
         calcWatcher->waitForFinished();
     }
+    if(tuneWatcher->isRunning()) {
+        tuneWatcher->waitForFinished();
+    }
 }
 
 void MainWindow::onStartClicked()
 {
     // Disable Start, enable Stop
     startButton->setEnabled(false);
+    autotuneButton->setEnabled(false);
     stopButton->setEnabled(true);
 
-    outputTextEdit->clear();
-    outputTextEdit->append("Розрахунки запущено...");
+    outputModel->clear();
+    outputModel->appendLine("Розрахунки запущено...");
 
     // Reset the stop flag
     stopFlag.store(false);
@@ -136,9 +179,13 @@ void MainWindow::onStartClicked()
     // Get parameters from the UI and store them for later output
     currentLimit = limitSpinBox->value();
     currentNumThreads = threadSlider->value();
+    CollatzOptions options = tunedOptions;
+    options.numThreads = currentNumThreads;
 
     // Launch the Collatz calculation asynchronously using the CollatzCalculator module
-    QFuture<CollatzResult> future = QtConcurrent::run(&CollatzCalculator::calculate, currentLimit, currentNumThreads, std::ref(stopFlag));
+    QFuture<CollatzResult> future = QtConcurrent::run([this, limit = currentLimit, options]() {
+        return CollatzCalculator::calculate(limit, options, stopFlag);
+    });
     calcWatcher->setFuture(future);
 }
 
@@ -146,27 +193,57 @@ void MainWindow::onStopClicked()
 {
     // Signal cancellation of the calculation
     stopFlag.store(true);
-    outputTextEdit->append("Зупинка обчислень...");
+    outputModel->appendLine("Зупинка обчислень...");
 }
 
 void MainWindow::onTestClicked()
 {
-    outputTextEdit->clear();
-    outputTextEdit->append("----- Test Sequence for 13 -----");
+    outputModel->clear();
+    outputModel->appendLine("----- Test Sequence for 13 -----");
     try {
-        // Call the test function from CollatzCalculator
-        CollatzTestResult testRes = CollatzCalculator::getTestSequence(13);
         // Output the full sequence and its length.
-        outputTextEdit->append(QString("Sequence: %1").arg(testRes.sequence));
-        outputTextEdit->append(QString("Sequence length: %1").arg(testRes.length));
+        // Kept as numbers: the view formats only the rows on screen
+        std::vector<quint64> sequence = CollatzLengthOracle::sequence(13);
+        if (sequence.empty()) {
+            throw std::overflow_error("64-bit integer overflow during calculation");
+        }
+        quint64 length = sequence.size();
+        outputModel->appendLine("Sequence:");
+        outputModel->appendSequence(std::move(sequence));
+        outputModel->appendLine(QString("Sequence length: %1").arg(length));
     } catch (const std::exception &e) {
-        outputTextEdit->append(QString("Test Error: %1").arg(e.what()));
+        outputModel->appendLine(QString("Test Error: %1").arg(e.what()));
     }
-    outputTextEdit->append("----- End of Test -----");
+    outputModel->appendLine("----- End of Test -----");
+}
+
+void MainWindow::onAutotuneClicked()
+{
+    startButton->setEnabled(false);
+    autotuneButton->setEnabled(false);
+    stopButton->setEnabled(true);
+
+    outputModel->clear();
+    outputModel->appendLine("Калібрування запущено...");
+
+    stopFlag.store(false);
+    tuneWatcher->setFuture(QtConcurrent::run(&CollatzAutotuner::calibrate, std::ref(stopFlag)));
 }
 
 void MainWindow::resetUI()
 {
     startButton->setEnabled(true);
+    autotuneButton->setEnabled(true);
     stopButton->setEnabled(false);
 }
+
+void MainWindow::applyProfile(const CollatzProfile &profile)
+{
+    tunedOptions = profile.options;
+    threadSlider->setValue(profile.options.numThreads);
+    outputModel->appendLine(QString("Профіль: ядро %1, потоків %2, блок %3, мемо %4")
+                               .arg(CollatzCalculator::kernelName(profile.options.kernel))
+                               .arg(profile.options.numThreads)
+                               .arg(profile.options.blockSize)
+                               .arg(profile.options.memoSize));
+}
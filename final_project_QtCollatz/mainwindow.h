@@ -5,11 +5,13 @@
 #include <atomic>
 #include <QFutureWatcher>
 #include "collatzcalculator.h"  // Collatz calculation module
+#include "collatzautotuner.h"   // Calibration of the calculation options
+#include "collatzoutputmodel.h" // Contents of the output panel
 
 class QPushButton;
 class QSlider;
 class QSpinBox;
-class QTextEdit;
+class QListView;
 
 class MainWindow : public QMainWindow
 {
@@ -23,6 +25,7 @@ private slots:
     void onStartClicked();
     void onStopClicked();
     void onTestClicked();
+    void onAutotuneClicked();
 
 private:
     // UI elements
@@ -30,17 +33,27 @@ private:
     QPushButton *startButton;
     QPushButton *stopButton;
     QPushButton *testButton;
+    QPushButton *autotuneButton;
     QSlider     *threadSlider;
     QSpinBox    *limitSpinBox;
-    QTextEdit   *outputTextEdit;
+    QListView   *outputView;
+    CollatzOutputModel *outputModel;
 
     std::atomic_bool stopFlag;
     QFutureWatcher<CollatzResult> *calcWatcher;
+    QFutureWatcher<CollatzProfile> *tuneWatcher;
+
+    // Kernel, block size and memo size from the tuning profile;
+    // the thread count always comes from the slider.
+    CollatzOptions tunedOptions;
+
+    bool followOutput = true;   // Output view was scrolled to the bottom before the last insert.
 
     quint64 currentLimit;
     int currentNumThreads;
 
     void resetUI();
+    void applyProfile(const CollatzProfile &profile);
 };
 
 #endif // MAINWINDOW_H
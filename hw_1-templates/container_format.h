@@ -0,0 +1,117 @@
+#ifndef CONTAINER_FORMAT_H
+#define CONTAINER_FORMAT_H
+
+#include <charconv>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "io_utils.h"
+
+// Number-like elements are formatted with std::to_chars: no locale, no stream state.
+// char, bool and everything else keep their operator<< output.
+template <typename T>
+constexpr bool formatsWithToChars =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+    !std::is_same_v<T, char> && !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char> &&
+    !std::is_same_v<T, wchar_t> && !std::is_same_v<T, char8_t> &&
+    !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
+
+// serializes container output: a container is written by one thread at a time,
+// so its text is not interleaved with another container's even when it needs several writes
+inline std::mutex& containerOutputMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+/* appends "element " texts to a caller-supplied buffer and writes it out in large blocks */
+class ContainerWriter {
+private:
+    int _fd;
+    std::span<char> _buffer;
+    size_t _used = 0;
+    std::unique_lock<std::mutex> _lock{ containerOutputMutex(), std::defer_lock };
+
+    void flush() {
+        if (!_lock.owns_lock()) _lock.lock();
+        writeAll(_fd, _buffer.data(), _used);
+        _used = 0;
+    }
+
+    // makes room for size characters; false if they can never fit
+    bool reserve(size_t size) {
+        if (_buffer.size() - _used < size) flush();
+        return size <= _buffer.size();
+    }
+
+public:
+    ContainerWriter(int fd, std::span<char> buffer) : _fd(fd), _buffer(buffer) {}
+
+    void append(std::string_view text) {
+        if (reserve(text.size())) {
+            std::memcpy(_buffer.data() + _used, text.data(), text.size());
+            _used += text.size();
+        } else {
+            writeAll(_fd, text.data(), text.size());  // larger than the whole buffer
+        }
+    }
+
+    void append(char c) {
+        reserve(1);
+        _buffer[_used++] = c;
+    }
+
+    template <typename T>
+    void appendElement(const T& element) {
+        if constexpr (formatsWithToChars<T>) {
+            // 64 covers any integer and a float with 6 significant digits
+            reserve(64);
+            std::to_chars_result result;
+            if constexpr (std::is_floating_point_v<T>) {
+                // same text as operator<< with the default precision of 6
+                result = std::to_chars(_buffer.data() + _used, _buffer.data() + _buffer.size(), element,
+                                       std::chars_format::general, 6);
+            } else {
+                result = std::to_chars(_buffer.data() + _used, _buffer.data() + _buffer.size(), element);
+            }
+            _used = static_cast<size_t>(result.ptr - _buffer.data());
+        } else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+                             std::is_same_v<T, unsigned char>) {
+            append(static_cast<char>(element));  // operator<< prints these as characters
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            append(std::string_view(element));
+        } else {
+            // anything else: its own operator<<, through a stream reused by this thread
+            thread_local std::ostringstream stream;
+            stream.str(std::string());
+            stream << element;
+            append(std::string_view(stream.view()));
+        }
+    }
+
+    // writes what is left; when the whole text fit into the buffer this is the only write
+    void finish() {
+        if (_used > 0) flush();
+        if (_lock.owns_lock()) _lock.unlock();
+    }
+};
+
+// writes "e1 e2 ... en \n" to a file descriptor, using buffer (at least 64 bytes) for formatting.
+// Output that fits into the buffer goes out with a single write call; larger output is
+// flushed in buffer-sized blocks while holding containerOutputMutex().
+template <typename Container>
+void writeContainer(int fd, const Container& container, std::span<char> buffer) {
+    ContainerWriter writer(fd, buffer);
+    for (const auto& element : container) {
+        writer.appendElement(element);
+        writer.append(' ');
+    }
+    writer.append('\n');
+    writer.finish();
+}
+
+#endif // CONTAINER_FORMAT_H
@@ -0,0 +1,185 @@
+#ifndef HEX_DIFF_H
+#define HEX_DIFF_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HEX_DIFF_SSE2 1
+#endif
+
+#include "hex_dump.h"
+
+// Diff layout: only the 16-byte lines that differ are printed, in the hex dump layout,
+// together with up to `context` equal lines around them. Every group of adjacent lines
+// starts with the offset of its first line:
+//   "@@ 00000100 @@\n"
+//   "  00000100: 45 46 47 ...  EFG...\n"   equal in both files
+//   "- 00000110: 48 49 4a ...  HIJ...\n"   line of the old file
+//   "+ 00000110: 48 58 4a ...  HXJ...\n"   line of the new file
+// Lines past the end of the shorter file have only their "-" or "+" half.
+
+constexpr size_t hexDiffHeaderLength = 3 + 16 + 4;  // "@@ " 16-digit offset " @@\n"
+constexpr size_t hexDiffLineLength = 2 + hexMaxLineLength;
+
+// the two files being compared, cut into 16-byte lines at the same offsets
+struct HexDiffFiles {
+    const unsigned char* oldData;
+    size_t oldSize;
+    const unsigned char* newData;
+    size_t newSize;
+
+    uint64_t lines() const { return (std::max(oldSize, newSize) + hexBytesPerLine - 1) / hexBytesPerLine; }
+
+    // lines that are complete in both files
+    uint64_t commonLines() const { return std::min(oldSize, newSize) / hexBytesPerLine; }
+
+    static size_t lineBytes(size_t size, uint64_t line) {
+        uint64_t offset = line * hexBytesPerLine;
+        return offset < size ? static_cast<size_t>(std::min<uint64_t>(hexBytesPerLine, size - offset)) : 0;
+    }
+
+    bool differs(uint64_t line) const {
+        size_t count = lineBytes(oldSize, line);
+        return count != lineBytes(newSize, line)
+            || std::memcmp(oldData + line * hexBytesPerLine, newData + line * hexBytesPerLine, count) != 0;
+    }
+};
+
+// index of the first line in [line, end) where a and b differ, or end; the lines must be
+// complete in both buffers. Equal data is compared 64 bytes per step.
+inline uint64_t firstDifferentLine(const unsigned char* a, const unsigned char* b, uint64_t line, uint64_t end) {
+#ifdef HEX_DIFF_SSE2
+    auto equal = [&](uint64_t i) {
+        const __m128i* x = reinterpret_cast<const __m128i*>(a + i * hexBytesPerLine);
+        const __m128i* y = reinterpret_cast<const __m128i*>(b + i * hexBytesPerLine);
+        return _mm_cmpeq_epi8(_mm_loadu_si128(x), _mm_loadu_si128(y));
+    };
+    for (; line + 4 <= end; line += 4) {
+        __m128i all = _mm_and_si128(_mm_and_si128(equal(line), equal(line + 1)),
+                                    _mm_and_si128(equal(line + 2), equal(line + 3)));
+        if (_mm_movemask_epi8(all) != 0xffff) break;
+    }
+    for (; line < end; ++line) {
+        if (_mm_movemask_epi8(equal(line)) != 0xffff) return line;
+    }
+#else
+    constexpr uint64_t step = 4;
+    for (; line + step <= end; line += step) {
+        if (std::memcmp(a + line * hexBytesPerLine, b + line * hexBytesPerLine, step * hexBytesPerLine) != 0) break;
+    }
+    for (; line < end; ++line) {
+        if (std::memcmp(a + line * hexBytesPerLine, b + line * hexBytesPerLine, hexBytesPerLine) != 0) return line;
+    }
+#endif
+    return end;
+}
+
+// appends the indices of the differing lines in [from, to) to out, in ascending order
+inline void findDifferentLines(const HexDiffFiles& files, uint64_t from, uint64_t to, std::vector<uint64_t>& out) {
+    uint64_t fastEnd = std::min(to, files.commonLines());
+    for (uint64_t line = from; line < fastEnd; ++line) {
+        line = firstDifferentLine(files.oldData, files.newData, line, fastEnd);
+        if (line < fastEnd) out.push_back(line);
+    }
+    // the last, partial line and the tail of the longer file
+    for (uint64_t line = std::max(from, fastEnd); line < to; ++line) {
+        if (files.differs(line)) out.push_back(line);
+    }
+}
+
+// formats the part of the diff that lies in lines [first, last) into buffer (grown as
+// needed) and returns its length. A line is printed if a differing line is at most context
+// lines away, so the differences up to context + 1 lines beyond the range are looked at as
+// well; this lets every range be formatted on its own. changed is scratch space.
+inline size_t formatHexDiff(std::vector<char>& buffer, const HexDiffFiles& files, uint64_t first, uint64_t last,
+                            uint64_t context, std::vector<uint64_t>& changed) {
+    changed.clear();
+    uint64_t from = first > context + 1 ? first - context - 1 : 0;
+    uint64_t to = std::min(files.lines(), last + context);
+    findDifferentLines(files, from, to, changed);
+    if (changed.empty()) return 0;
+
+    size_t capacity = static_cast<size_t>(last - first) * (2 * hexDiffLineLength + hexDiffHeaderLength);
+    if (buffer.size() < capacity) buffer.resize(capacity);
+    char* out = buffer.data();
+    size_t pos = 0;
+
+    auto printLine = [&](const char* prefix, const unsigned char* data, size_t size, uint64_t line) {
+        std::memcpy(out + pos, prefix, 2);
+        pos += 2;
+        uint64_t offset = line * hexBytesPerLine;
+        pos += formatHexLine(out + pos, offset, data + offset, HexDiffFiles::lineBytes(size, line));
+    };
+    auto printHeader = [&](uint64_t line) {
+        uint64_t offset = line * hexBytesPerLine;
+        int digits = 8;
+        while (digits < 16 && (offset >> (4 * digits)) != 0) ++digits;
+        std::memcpy(out + pos, "@@ ", 3);
+        pos += 3;
+        for (int i = digits - 1; i >= 0; --i) {
+            out[pos++] = "0123456789abcdef"[(offset >> (4 * i)) & 15];
+        }
+        std::memcpy(out + pos, " @@\n", 4);
+        pos += 4;
+    };
+
+    // Groups: the windows [c - context, c + context] around the changed lines c, merged where
+    // they overlap or touch. A group that starts before first is continued from the previous range.
+    size_t next = 0;   // first changed line not yet printed
+    size_t i = 0;
+    while (i < changed.size()) {
+        uint64_t start = changed[i] > context ? changed[i] - context : 0;
+        uint64_t end = changed[i] + context + 1;
+        for (++i; i < changed.size() && changed[i] - std::min(changed[i], context) <= end; ++i) {
+            end = changed[i] + context + 1;
+        }
+        uint64_t begin = std::max(start, first);
+        end = std::min(end, last);
+        if (begin >= end) continue;
+
+        if (start >= first) printHeader(start);
+        while (next < changed.size() && changed[next] < begin) ++next;
+        for (uint64_t line = begin; line < end; ++line) {
+            if (next < changed.size() && changed[next] == line) {
+                ++next;
+                if (HexDiffFiles::lineBytes(files.oldSize, line) > 0) printLine("- ", files.oldData, files.oldSize, line);
+                if (HexDiffFiles::lineBytes(files.newSize, line) > 0) printLine("+ ", files.newData, files.newSize, line);
+            } else {
+                printLine("  ", files.oldData, files.oldSize, line);
+            }
+        }
+    }
+    return pos;
+}
+
+// writes the diff of two files to a file descriptor and returns the number of differing lines.
+// The lines are cut into ranges that worker threads compare and format on their own, and the
+// calling thread writes the results in order (see writeSegmentsInOrder). Equal data is only
+// compared, so the run time depends on the memory bandwidth and the amount of differences,
+// and output starts as soon as the first difference is found. threads == 0 uses all hardware threads.
+inline uint64_t hexDiffToFd(int fd, const HexDiffFiles& files, uint64_t context = 3, unsigned threads = 0) {
+    constexpr uint64_t segmentLines = uint64_t(1) << 14;  // 256 KiB of each file
+
+    uint64_t lines = files.lines();
+    context = std::min(context, lines);
+    size_t segments = static_cast<size_t>((lines + segmentLines - 1) / segmentLines);
+    std::atomic<uint64_t> differing{0};
+    writeSegmentsInOrder(fd, segments, threads, [&](size_t s, std::vector<char>& buffer) {
+        thread_local std::vector<uint64_t> changed;
+        uint64_t first = s * segmentLines;
+        uint64_t last = std::min(lines, first + segmentLines);
+        size_t length = formatHexDiff(buffer, files, first, last, context, changed);
+        uint64_t own = static_cast<uint64_t>(std::count_if(changed.begin(), changed.end(),
+                                                           [&](uint64_t line) { return line >= first && line < last; }));
+        differing.fetch_add(own, std::memory_order_relaxed);
+        return length;
+    });
+    return differing.load();
+}
+
+#endif // HEX_DIFF_H
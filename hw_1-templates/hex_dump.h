@@ -0,0 +1,219 @@
+#ifndef HEX_DUMP_H
+#define HEX_DUMP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "io_utils.h"
+
+// Line layout (same as the original printAsHex):
+//   "0000abc0: 45 46 47 48 49 4a 4b 4c | 4d 4e 4f 50 51 52 53 54  EFGHIJKLMNOPQRST\n"
+// The offset has at least 8 hex digits; short last lines are padded so the
+// ASCII column lines up (one column earlier for lines of 8 bytes or less, whose padding has no "| ").
+
+constexpr size_t hexBytesPerLine = 16;  // number of bytes per line
+constexpr size_t hexBlockSize = 8;      // block size for splitting
+constexpr size_t hexMaxLineLength = 16 + 2 + 50 + 1 + 16 + 1;  // 16-digit offset, longest possible line
+
+/* lookup tables: every byte is formatted with one table read instead of a stream operation */
+struct HexTables {
+    uint32_t triples[256];  // "xx " plus a spare byte, stored with one 4-byte write
+    char pairs[256][2];     // "xx"
+    char ascii[256];        // printable characters as is, '.' for others (isprint in the "C" locale)
+
+    HexTables() {
+        const char digits[] = "0123456789abcdef";
+        for (int i = 0; i < 256; ++i) {
+            const char triple[4] = { digits[i >> 4], digits[i & 15], ' ', ' ' };
+            std::memcpy(&triples[i], triple, 4);
+            std::memcpy(pairs[i], triple, 2);
+            ascii[i] = (i >= 0x20 && i < 0x7f) ? static_cast<char>(i) : '.';
+        }
+    }
+};
+
+inline const HexTables hexTables;
+
+// formats one line of up to 16 bytes into out (at least hexMaxLineLength bytes);
+// returns the number of characters written
+inline size_t formatHexLine(char* out, uint64_t offset, const unsigned char* bytes, size_t count) {
+    const HexTables& t = hexTables;
+    char* p = out;
+
+    // offset: 8 hex digits unless it needs more
+    if (offset <= 0xffffffffu) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            std::memcpy(p, t.pairs[(offset >> shift) & 0xff], 2);
+            p += 2;
+        }
+    } else {
+        int digits = 8;
+        while (digits < 16 && (offset >> (4 * digits)) != 0) ++digits;
+        for (int i = digits - 1; i >= 0; --i) {
+            *p++ = "0123456789abcdef"[(offset >> (4 * i)) & 15];
+        }
+    }
+    *p++ = ':';
+    *p++ = ' ';
+
+    // hex bytes: 4-byte stores advanced by 3, the spare byte is overwritten by the next one
+    for (size_t i = 0; i < count; ++i) {
+        if (i == hexBlockSize) {
+            *p++ = '|';
+            *p++ = ' ';
+        }
+        std::memcpy(p, &t.triples[bytes[i]], 4);
+        p += 3;
+    }
+
+    // fill spaces for alignment if the line is shorter
+    for (size_t i = count; i < hexBytesPerLine; ++i) {
+        if (i > 0 && i % hexBlockSize == 0) {
+            *p++ = ' ';  // maintain block alignment
+        }
+        std::memcpy(p, "   ", 3);
+        p += 3;
+    }
+
+    // ASCII representation
+    *p++ = ' ';
+    for (size_t i = 0; i < count; ++i) {
+        *p++ = t.ascii[bytes[i]];
+    }
+    *p++ = '\n';
+    return static_cast<size_t>(p - out);
+}
+
+// upper bound of the dump length of size bytes
+constexpr size_t hexDumpCapacity(size_t size) {
+    return (size + hexBytesPerLine - 1) / hexBytesPerLine * hexMaxLineLength;
+}
+
+// formats data[0..size) into out (at least hexDumpCapacity(size) bytes); baseOffset
+// is the offset printed for data[0]. Returns the number of characters written.
+inline size_t formatHexDump(char* out, const unsigned char* data, size_t size, uint64_t baseOffset = 0) {
+    size_t pos = 0;
+    for (size_t i = 0; i < size; i += hexBytesPerLine) {
+        pos += formatHexLine(out + pos, baseOffset + i, data + i, std::min(hexBytesPerLine, size - i));
+    }
+    return pos;
+}
+
+// appends the dump of data[0..size) to out
+inline void appendHexDump(std::string& out, const unsigned char* data, size_t size, uint64_t baseOffset = 0) {
+    size_t pos = out.size();
+    out.resize(pos + hexDumpCapacity(size));
+    out.resize(pos + formatHexDump(&out[pos], data, size, baseOffset));
+}
+
+// Produces the output of segments 0..segments-1 in parallel and writes it to a file
+// descriptor in order. format(s, buffer) writes the text of segment s into buffer (growing
+// it as needed) and returns its length. Worker threads format segments into their own
+// buffers while the calling thread writes the finished ones in order, each with a single
+// write call; empty segments cost no write. threads == 0 uses all hardware threads.
+template <typename Format>
+void writeSegmentsInOrder(int fd, size_t segments, unsigned threads, Format format) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, segments));
+
+    if (threads <= 1) {
+        std::vector<char> buffer;
+        for (size_t s = 0; s < segments; ++s) {
+            size_t length = format(s, buffer);
+            if (length > 0) writeAll(fd, buffer.data(), length);
+        }
+        return;
+    }
+
+    // Segment s goes through slot s % slotCount. A worker may fill the slot once
+    // the writer has written segment s - slotCount; the writer waits until it is ready.
+    constexpr uint64_t aborted = ~0ULL;
+    struct alignas(64) Slot {
+        std::vector<char> buffer;
+        size_t length = 0;
+        std::atomic<uint64_t> freeFor{0};  // segment that may be formatted into this slot next
+        std::atomic<uint64_t> ready{0};    // segment + 1 once it is formatted
+    };
+    const size_t slotCount = 2 * static_cast<size_t>(threads);
+    std::unique_ptr<Slot[]> slots(new Slot[slotCount]);
+    for (size_t i = 0; i < slotCount; ++i) {
+        slots[i].freeFor.store(i);
+    }
+
+    std::atomic<size_t> nextSegment{0};
+    std::exception_ptr workerError;
+    std::atomic<bool> failed{false};
+    auto worker = [&]() {
+        for (;;) {
+            size_t s = nextSegment.fetch_add(1, std::memory_order_relaxed);
+            if (s >= segments) return;
+            Slot& slot = slots[s % slotCount];
+            for (uint64_t v; (v = slot.freeFor.load(std::memory_order_acquire)) != s;) {
+                if (v == aborted) return;
+                slot.freeFor.wait(v);
+            }
+            try {
+                slot.length = format(s, slot.buffer);
+            } catch (...) {
+                // the first error is rethrown by the writer; the segment is left empty
+                if (!failed.exchange(true)) workerError = std::current_exception();
+                slot.length = 0;
+            }
+            slot.ready.store(s + 1, std::memory_order_release);
+            slot.ready.notify_one();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+
+    std::exception_ptr error;
+    try {
+        for (size_t s = 0; s < segments; ++s) {
+            Slot& slot = slots[s % slotCount];
+            for (uint64_t v; (v = slot.ready.load(std::memory_order_acquire)) != s + 1;) {
+                slot.ready.wait(v);
+            }
+            if (failed.load(std::memory_order_acquire)) break;
+            if (slot.length > 0) writeAll(fd, slot.buffer.data(), slot.length);
+            slot.freeFor.store(s + slotCount, std::memory_order_release);
+            slot.freeFor.notify_all();
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (size_t i = 0; i < slotCount; ++i) {
+        slots[i].freeFor.store(aborted);
+        slots[i].freeFor.notify_all();
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (error) std::rethrow_exception(error);
+    if (workerError) std::rethrow_exception(workerError);
+}
+
+// dumps data[0..size) to a file descriptor, formatted in parallel (see writeSegmentsInOrder).
+// threads == 0 uses all hardware threads.
+inline void hexDumpToFd(int fd, const unsigned char* data, size_t size, unsigned threads = 0) {
+    constexpr size_t segmentBytes = hexBytesPerLine << 14;  // 256 KiB of input, ~1.1 MB of output
+
+    size_t segments = (size + segmentBytes - 1) / segmentBytes;
+    writeSegmentsInOrder(fd, segments, threads, [&](size_t s, std::vector<char>& buffer) {
+        if (buffer.size() < hexDumpCapacity(segmentBytes)) buffer.resize(hexDumpCapacity(segmentBytes));
+        size_t begin = s * segmentBytes;
+        return formatHexDump(buffer.data(), data + begin, std::min(segmentBytes, size - begin), begin);
+    });
+}
+
+#endif // HEX_DUMP_H
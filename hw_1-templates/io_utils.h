@@ -0,0 +1,151 @@
+#ifndef IO_UTILS_H
+#define IO_UTILS_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+inline std::system_error lastSystemError(const std::string& what) {
+    return std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+}
+#else
+inline std::system_error lastSystemError(const std::string& what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+#endif
+
+/* read-only memory mapping of a whole file */
+class MappedFile {
+private:
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#endif
+
+    void release() noexcept {
+#ifdef _WIN32
+        if (_data) UnmapViewOfFile(_data);
+        if (_mapping) CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data) munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+public:
+    MappedFile() = default;
+
+    // maps the file; throws std::system_error if it cannot be opened or mapped
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) throw lastSystemError("cannot open " + path);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(_file, &size)) {
+            std::system_error error = lastSystemError("cannot stat " + path);
+            release();
+            throw error;
+        }
+        _size = static_cast<size_t>(size.QuadPart);
+        if (_size == 0) return;  // empty files cannot be mapped
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping) {
+            _data = static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!_data) {
+            std::system_error error = lastSystemError("cannot map " + path);
+            release();
+            throw error;
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw lastSystemError("cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            std::system_error error = lastSystemError("cannot stat " + path);
+            close(fd);
+            throw error;
+        }
+        _size = static_cast<size_t>(st.st_size);
+        if (_size != 0) {
+            void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                std::system_error error = lastSystemError("cannot map " + path);
+                close(fd);
+                _size = 0;
+                throw error;
+            }
+            _data = static_cast<const unsigned char*>(data);
+            madvise(data, _size, MADV_SEQUENTIAL);  // only a hint: read-ahead aggressively
+        }
+        close(fd);  // the mapping stays valid without the descriptor
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            release();
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+#ifdef _WIN32
+            std::swap(_file, other._file);
+            std::swap(_mapping, other._mapping);
+#endif
+        }
+        return *this;
+    }
+
+    ~MappedFile() { release(); }
+
+    const unsigned char* data() const { return _data; }
+    size_t size() const { return _size; }
+};
+
+// writes the whole buffer to a file descriptor (1 = stdout), retrying short writes;
+// throws std::system_error on failure
+inline void writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        // _write takes an unsigned int count
+        unsigned int chunk = static_cast<unsigned int>(size < (1u << 30) ? size : (1u << 30));
+        int written = _write(fd, data, chunk);
+#else
+        ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR) continue;
+#endif
+        if (written < 0) throw std::system_error(errno, std::generic_category(), "write failed");
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+#endif // IO_UTILS_H
@@ -2,79 +2,104 @@
 #include <iostream>
 #include <iomanip>
 #include <list>
+#include <ranges>
 #include <set>
 #include <sstream>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
+#include "container_format.h"
+#include "hex_diff.h"
+#include "hex_dump.h"
+
 template <typename Container>
 void printContainer(const Container& container) {
 
-    std::ostringstream output;
-    for (const auto& element : container) {
-        output << element << " ";
-    }
-
-    output << std::endl;
+    // Formatting buffer reused by every call on this thread: no allocations for numbers
+    // and strings, and large containers are written out in 64 KiB blocks.
+    thread_local char buffer[1 << 16];
 
-    // Print the entire result with a single cout call.
-    // This approach is thread-safe and ensures that the output string
-    // will not be interrupted by other threads, as the standard guarantees
-    // atomicity for individual << operations on std::cout [C++17 27.4.1.3.2]
-    std::cout << output.str();
+    // Text that fits into the buffer is printed with a single write call, so it will not
+    // be interrupted by other threads; longer output is written under a mutex shared by
+    // all printContainer calls (see writeContainer).
+    std::cout.flush();
+    writeContainer(1, container, buffer);
 }
 
 template <typename Container>
 void printAsHex(const Container& container) {
-    constexpr size_t bytesPerLine = 16;  // number of bytes per line
-    constexpr size_t blockSize = 8;  // block size for splitting
-
-    size_t offset = 0;
-    std::ostringstream output;
-
-    for (auto it = container.cbegin(); it != container.cend(); offset += bytesPerLine) {
-
-        // print the offset
-        output << std::setw(8) << std::setfill('0') << std::hex << offset << ": ";
-
-        // print the hex representation with blocks of 8 bytes
-        auto lineIt = it;
-        for (size_t i = 0; i < bytesPerLine && lineIt != container.cend(); ++i, ++lineIt) {
-            if (i > 0 && i % blockSize == 0) {
-                output << "| ";  // add a space every blockSize bytes
-            }
-            output << std::setw(2) << std::setfill('0') << std::hex
-                   << static_cast<int>(static_cast<unsigned char>(*lineIt)) << " ";
-        }
-
-        // fill spaces for alignment if the line is shorter
-        for (size_t i = std::distance(it, lineIt); i < bytesPerLine; ++i) {
-            if (i > 0 && i % blockSize == 0) {
-                output << " "; // maintain block alignment
-            }
-            output << "   ";
+    std::string output;
+
+    if constexpr (std::ranges::contiguous_range<Container> && sizeof(std::ranges::range_value_t<Container>) == 1) {
+        // bytes already lie in one block of memory: format them in place
+        appendHexDump(output, reinterpret_cast<const unsigned char*>(std::ranges::data(container)),
+                      std::ranges::size(container));
+    } else {
+        // only the low byte of every element is shown, as before
+        std::vector<unsigned char> bytes;
+        for (const auto& element : container) {
+            bytes.push_back(static_cast<unsigned char>(element));
         }
-
-        // print ASCII representation
-        output << " ";
-        lineIt = it;
-        for (size_t i = 0; i < bytesPerLine && lineIt != container.cend(); ++i, ++lineIt) {
-            char c = static_cast<char>(*lineIt);
-            output << (std::isprint(static_cast<unsigned char>(c)) ? c : '.');
-        }
-
-        output << "\n";
-        it = lineIt;
+        appendHexDump(output, bytes.data(), bytes.size());
     }
 
     // Print the entire result with a single cout call.
     // This approach is thread-safe and ensures that the output string
     // will not be interrupted by other threads, as the standard guarantees
     // atomicity for individual << operations on std::cout [C++17 27.4.1.3.2]
-    std::cout << output.str();
+    std::cout << output;
+}
+
+// Dump mode: "hw1 dump <file> [threads]" prints the hex dump of a file of any size.
+// The file is memory-mapped and formatted by all cores; output goes straight to stdout.
+int dumpFile(const char* path, const char* threadsArg) {
+    try {
+        unsigned threads = threadsArg ? static_cast<unsigned>(std::stoul(threadsArg)) : 0;
+        MappedFile file(path);
+        std::cout.flush();
+        hexDumpToFd(1, file.data(), file.size(), threads);
+    } catch (const std::logic_error&) {
+        // std::invalid_argument or std::out_of_range from a malformed number
+        std::cerr << "Usage: hw1 dump <file> [threads]" << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
 }
 
-int main() {
+// Diff mode: "hw1 diff <old> <new> [context] [threads]" prints the 16-byte lines that differ
+// between two files, with context equal lines around them (3 by default).
+// Both files are memory-mapped and compared by all cores. Exit code as for cmp and diff:
+// 0 if the files are equal, 1 if they differ, 2 on errors.
+int diffFiles(const char* oldPath, const char* newPath, const char* contextArg, const char* threadsArg) {
+    try {
+        uint64_t context = contextArg ? std::stoull(contextArg) : 3;
+        unsigned threads = threadsArg ? static_cast<unsigned>(std::stoul(threadsArg)) : 0;
+        MappedFile oldFile(oldPath);
+        MappedFile newFile(newPath);
+        std::cout.flush();
+        HexDiffFiles files{ oldFile.data(), oldFile.size(), newFile.data(), newFile.size() };
+        return hexDiffToFd(1, files, context, threads) == 0 ? 0 : 1;
+    } catch (const std::logic_error&) {
+        std::cerr << "Usage: hw1 diff <old> <new> [context] [threads]" << std::endl;
+        return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc >= 3 && std::string(argv[1]) == "dump") {
+        return dumpFile(argv[2], argc >= 4 ? argv[3] : nullptr);
+    }
+    if (argc >= 4 && std::string(argv[1]) == "diff") {
+        return diffFiles(argv[2], argv[3], argc >= 5 ? argv[4] : nullptr, argc >= 6 ? argv[5] : nullptr);
+    }
 
     // Part 1: Mandatory Task
     // Demonstrates the generic printContainer function with different STL containers.
@@ -0,0 +1,189 @@
+#ifndef ALLOCATORS_H
+#define ALLOCATORS_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <new>
+
+// Allocator backends for BasicInternalArray.
+//
+// An allocator is a small copyable handle with
+//     void* allocate(size_t bytes);               // 64-byte aligned, throws std::bad_alloc
+//     void deallocate(void* ptr, size_t bytes);   // bytes as passed to allocate
+// An array keeps a copy of the handle it was created with and takes the handle
+// of the array it is moved from, so memory always goes back to where it came from.
+
+constexpr size_t allocationAlignment = 64;  // cache line
+
+inline void* alignedNew(size_t bytes) {
+    return ::operator new(bytes, std::align_val_t{ allocationAlignment });
+}
+
+inline void alignedDelete(void* ptr) {
+    ::operator delete(ptr, std::align_val_t{ allocationAlignment });
+}
+
+/* the global heap: every allocation is a separate new/delete */
+struct HeapAllocator {
+    void* allocate(size_t bytes) { return alignedNew(bytes); }
+    void deallocate(void* ptr, size_t) { alignedDelete(ptr); }
+};
+
+/* request-scoped memory: allocation is a pointer bump, nothing is freed until reset() */
+class MonotonicArena {
+private:
+    struct alignas(allocationAlignment) Block {
+        Block* next;
+        size_t size;  // bytes including this header
+    };
+
+    Block* _blocks = nullptr;   // most recent first
+    char* _current = nullptr;   // free space of the most recent block
+    char* _end = nullptr;
+    size_t _nextBlockSize;
+
+    static constexpr size_t maxBlockSize = size_t(16) << 20;
+
+    void addBlock(size_t bytes) {
+        size_t size = std::max(_nextBlockSize, bytes + sizeof(Block));
+        Block* block = static_cast<Block*>(alignedNew(size));
+        block->next = _blocks;
+        block->size = size;
+        _blocks = block;
+        _current = reinterpret_cast<char*>(block + 1);
+        _end = reinterpret_cast<char*>(block) + size;
+        _nextBlockSize = std::min(_nextBlockSize * 2, maxBlockSize);
+    }
+
+    void releaseBlocks(Block* block) {
+        while (block) {
+            Block* next = block->next;
+            alignedDelete(block);
+            block = next;
+        }
+    }
+
+public:
+    explicit MonotonicArena(size_t initialBlockSize = size_t(64) << 10)
+        : _nextBlockSize(std::max(initialBlockSize, 2 * sizeof(Block))) {}
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() { releaseBlocks(_blocks); }
+
+    void* allocate(size_t bytes) {
+        bytes = (bytes + allocationAlignment - 1) & ~(allocationAlignment - 1);
+        if (static_cast<size_t>(_end - _current) < bytes) {
+            addBlock(bytes);
+        }
+        void* ptr = _current;
+        _current += bytes;
+        return ptr;
+    }
+
+    // frees everything allocated since the last reset at once; the largest (most recent)
+    // block is kept for the next request. Arrays using the arena must be gone by now.
+    void reset() {
+        if (!_blocks) return;
+        releaseBlocks(_blocks->next);
+        _blocks->next = nullptr;
+        _current = reinterpret_cast<char*>(_blocks + 1);
+        _end = reinterpret_cast<char*>(_blocks) + _blocks->size;
+    }
+};
+
+/* handle to a MonotonicArena: deallocate does nothing, memory is reclaimed by reset() */
+struct ArenaAllocator {
+    MonotonicArena* arena;
+
+    explicit ArenaAllocator(MonotonicArena& owner) : arena(&owner) {}
+
+    void* allocate(size_t bytes) { return arena->allocate(bytes); }
+    void deallocate(void*, size_t) {}
+};
+
+/* per-thread free lists for power-of-two size classes from 64 bytes to 1 MB */
+class SizeClassPool {
+private:
+    static constexpr size_t minClassShift = 6;   // 64 bytes
+    static constexpr size_t classCount = 15;     // ... 1 MB
+    static constexpr size_t maxCachedBytes = size_t(4) << 20;  // per class, bounds the memory kept
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    FreeBlock* _free[classCount] = {};
+    size_t _cached[classCount] = {};
+
+    static size_t classIndex(size_t bytes) {
+        size_t shift = std::bit_width(std::max(bytes, size_t(1) << minClassShift) - 1);
+        return shift - minClassShift;
+    }
+
+    static size_t classBytes(size_t index) {
+        return size_t(1) << (index + minClassShift);
+    }
+
+    static size_t maxCachedBlocks(size_t index) {
+        return std::max<size_t>(4, maxCachedBytes / classBytes(index));
+    }
+
+public:
+    SizeClassPool() = default;
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    ~SizeClassPool() {
+        for (FreeBlock* block : _free) {
+            while (block) {
+                FreeBlock* next = block->next;
+                alignedDelete(block);
+                block = next;
+            }
+        }
+    }
+
+    // the pool of the calling thread
+    static SizeClassPool& local() {
+        thread_local SizeClassPool pool;
+        return pool;
+    }
+
+    void* allocate(size_t bytes) {
+        size_t index = classIndex(bytes);
+        if (index >= classCount) {
+            return alignedNew(bytes);
+        }
+        if (FreeBlock* block = _free[index]) {
+            _free[index] = block->next;
+            --_cached[index];
+            return block;
+        }
+        return alignedNew(classBytes(index));
+    }
+
+    // blocks may come from another thread's pool: every block is a separate heap
+    // allocation of its class size, so it can be kept or freed anywhere
+    void deallocate(void* ptr, size_t bytes) {
+        size_t index = classIndex(bytes);
+        if (index >= classCount || _cached[index] >= maxCachedBlocks(index)) {
+            alignedDelete(ptr);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = _free[index];
+        _free[index] = block;
+        ++_cached[index];
+    }
+};
+
+/* handle to the calling thread's SizeClassPool */
+struct PoolAllocator {
+    void* allocate(size_t bytes) { return SizeClassPool::local().allocate(bytes); }
+    void deallocate(void* ptr, size_t bytes) { SizeClassPool::local().deallocate(ptr, bytes); }
+};
+
+#endif // ALLOCATORS_H
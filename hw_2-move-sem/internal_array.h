@@ -0,0 +1,255 @@
+#ifndef INTERNAL_ARRAY_H
+#define INTERNAL_ARRAY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+
+#include "allocators.h"
+
+// tag for the constructors that leave the elements uninitialized (shared by all allocators)
+struct InternalArrayUninitialized { explicit InternalArrayUninitialized() = default; };
+
+/* numeric buffer of ints with 64-byte aligned storage from Alloc (see allocators.h) */
+template <typename Alloc = HeapAllocator>
+class BasicInternalArray {
+public:
+    using Uninitialized = InternalArrayUninitialized;
+    static constexpr Uninitialized uninitialized{};
+
+    // cache line size: the buffer starts on a line boundary, so aligned SIMD loads/stores
+    // can be used for the bulk operations and no line is shared with another object
+    static constexpr size_t alignment = allocationAlignment;
+
+private:
+    int* m_pArray = nullptr;
+    unsigned int m_uiSize = 0;
+    unsigned int m_uiCapacity = 0;
+    [[no_unique_address]] Alloc m_allocator;
+
+    int* allocate(unsigned int count) {
+        // According to the C++ standard, allocating an array with size 0 is VALID,
+        // and the returned pointer is unique and non-null. However, implementations
+        // may differ in behavior, and dereferencing such a pointer results in undefined
+        // behavior. To ensure safety and compatibility, count == 0 is handled explicitly
+        // here and a null pointer is used for empty arrays everywhere.
+        if (count == 0) return nullptr;
+        return static_cast<int*>(m_allocator.allocate(count * sizeof(int)));
+    }
+
+    // count is the capacity the buffer was allocated with
+    void deallocate(int* ptr, unsigned int count) {
+        if (ptr) m_allocator.deallocate(ptr, count * sizeof(int));
+    }
+
+    // the data pointer with its alignment known to the compiler
+    int* alignedData() const {
+        return std::assume_aligned<alignment>(m_pArray);
+    }
+
+    // moves the elements into a new buffer of newCapacity >= m_uiSize elements
+    void reallocate(unsigned int newCapacity) {
+        int* newArray = allocate(newCapacity);
+        if (m_uiSize > 0) {
+            std::memcpy(newArray, m_pArray, m_uiSize * sizeof(int));
+        }
+        deallocate(m_pArray, m_uiCapacity);
+        m_pArray = newArray;
+        m_uiCapacity = newCapacity;
+    }
+
+    // capacity for at least count elements, at least doubling the current one
+    unsigned int grownCapacity(unsigned int count) const {
+        unsigned int doubled = m_uiCapacity > ~0u / 2 ? ~0u : m_uiCapacity * 2;
+        return std::max(count, doubled);
+    }
+
+public:
+
+    BasicInternalArray() = default;
+
+    explicit BasicInternalArray(const Alloc& allocator)
+        : m_allocator(allocator)
+    {
+    }
+
+    // newSize zero-initialized elements
+    BasicInternalArray(unsigned int newSize, const Alloc& allocator = Alloc())
+        : BasicInternalArray(newSize, uninitialized, allocator)
+    {
+        std::fill_n(alignedData(), m_uiSize, 0);
+    }
+
+    BasicInternalArray(unsigned int newSize, int value, const Alloc& allocator = Alloc())
+        : BasicInternalArray(newSize, uninitialized, allocator)
+    {
+        fill(value);
+    }
+
+    // newSize elements with indeterminate values: for buffers that are overwritten anyway
+    BasicInternalArray(unsigned int newSize, Uninitialized, const Alloc& allocator = Alloc())
+        : m_allocator(allocator)
+    {
+        m_pArray = allocate(newSize);
+        m_uiSize = newSize;
+        m_uiCapacity = newSize;
+    }
+
+    ~BasicInternalArray() {
+        deallocate(m_pArray, m_uiCapacity);
+    }
+
+    // the copy uses the same allocator as the original
+    BasicInternalArray(const BasicInternalArray& other)
+        : BasicInternalArray(other.m_uiSize, uninitialized, other.m_allocator)
+    {
+        if (m_uiSize > 0) {
+            std::memcpy(alignedData(), other.alignedData(), m_uiSize * sizeof(int));
+        }
+    }
+
+    // the allocator moves along with the buffer
+    BasicInternalArray(BasicInternalArray&& other) noexcept
+        : m_pArray(other.m_pArray)
+        , m_uiSize(other.m_uiSize)
+        , m_uiCapacity(other.m_uiCapacity)
+        , m_allocator(other.m_allocator)
+    {
+        other.m_pArray = nullptr;
+        other.m_uiSize = 0;
+        other.m_uiCapacity = 0;
+    }
+
+    // keeps this array's allocator and, if large enough, its buffer
+    BasicInternalArray& operator=(const BasicInternalArray& other)
+    {
+        if (this != &other) {
+            assign(other.m_pArray, other.m_uiSize);
+        }
+
+        return *this;
+    }
+
+    // takes the buffer together with the allocator it came from
+    BasicInternalArray& operator=(BasicInternalArray&& other) noexcept
+    {
+        if (this != &other) {
+            deallocate(m_pArray, m_uiCapacity);
+
+            m_pArray = other.m_pArray;
+            m_uiSize = other.m_uiSize;
+            m_uiCapacity = other.m_uiCapacity;
+            m_allocator = other.m_allocator;
+
+            other.m_pArray = nullptr;
+            other.m_uiSize = 0;
+            other.m_uiCapacity = 0;
+        }
+
+        return *this;
+    }
+
+    unsigned int size() const { return m_uiSize; }
+    unsigned int capacity() const { return m_uiCapacity; }
+    bool empty() const { return m_uiSize == 0; }
+    const Alloc& allocator() const { return m_allocator; }
+
+    int* data() { return m_pArray; }
+    const int* data() const { return m_pArray; }
+
+    int& operator[](unsigned int index) { return m_pArray[index]; }
+    const int& operator[](unsigned int index) const { return m_pArray[index]; }
+
+    int* begin() { return m_pArray; }
+    int* end() { return m_pArray + m_uiSize; }
+    const int* begin() const { return m_pArray; }
+    const int* end() const { return m_pArray + m_uiSize; }
+
+    // makes room for newCapacity elements without changing the size
+    void reserve(unsigned int newCapacity) {
+        if (newCapacity > m_uiCapacity) {
+            reallocate(newCapacity);
+        }
+    }
+
+    // new elements are zero-initialized
+    void resize(unsigned int newSize) {
+        unsigned int oldSize = m_uiSize;
+        resize(newSize, uninitialized);
+        if (newSize > oldSize) {
+            std::fill_n(alignedData() + oldSize, newSize - oldSize, 0);
+        }
+    }
+
+    // new elements are left uninitialized
+    void resize(unsigned int newSize, Uninitialized) {
+        if (newSize > m_uiCapacity) {
+            reallocate(grownCapacity(newSize));
+        }
+        m_uiSize = newSize;
+    }
+
+    void push_back(int value) {
+        if (m_uiSize == m_uiCapacity) {
+            reallocate(grownCapacity(m_uiSize + 1));
+        }
+        m_pArray[m_uiSize++] = value;
+    }
+
+    // keeps the capacity
+    void clear() {
+        m_uiSize = 0;
+    }
+
+    // replaces the contents with count values from source; the buffer is reused if it is large enough
+    void assign(const int* source, unsigned int count) {
+        if (count > m_uiCapacity) {
+            int* newArray = allocate(count);  // if this throws, the array is unchanged
+            deallocate(m_pArray, m_uiCapacity);
+            m_pArray = newArray;
+            m_uiCapacity = count;
+        }
+        m_uiSize = count;
+        if (count > 0) {
+            std::memmove(m_pArray, source, count * sizeof(int));
+        }
+    }
+
+    void fill(int value) {
+        std::fill_n(alignedData(), m_uiSize, value);
+    }
+
+    // element = f(element) for every element
+    template <typename F>
+    void transform(F f) {
+        int* p = alignedData();
+        for (unsigned int i = 0; i < m_uiSize; ++i) {
+            p[i] = f(p[i]);
+        }
+    }
+
+    // this[i] = f(source[i]); the size becomes source.size()
+    template <typename OtherAlloc, typename F>
+    void transform(const BasicInternalArray<OtherAlloc>& source, F f) {
+        resize(source.size(), uninitialized);
+        int* p = alignedData();
+        const int* s = std::assume_aligned<alignment>(source.data());
+        for (unsigned int i = 0; i < m_uiSize; ++i) {
+            p[i] = f(s[i]);
+        }
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const BasicInternalArray& array) {
+        for (unsigned int i = 0; i < array.m_uiSize; ++i) {
+            os << array.m_pArray[i] << " ";
+        }
+        return os;
+    }
+};
+
+using InternalArray = BasicInternalArray<>;
+
+#endif // INTERNAL_ARRAY_H
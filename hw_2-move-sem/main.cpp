@@ -1,95 +1,228 @@
 
-#include <utility>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "internal_array.h"
+
+// Times f() over several runs and prints the best one
+template <typename F>
+void benchmark(const char* name, F f) {
+    constexpr int runs = 5;
+    double best = 1e300;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    std::cout << "  " << std::left << std::setw(44) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(8) << best << " ms\n";
+}
+
+// InternalArray vs std::vector<int> on the bulk operations
+void runBenchmarks() {
+    constexpr unsigned int n = 1u << 22;  // 16 MB of ints
+    constexpr int rounds = 10;
+    volatile long long sink = 0;          // keeps the results alive
+
+    std::cout << "Benchmarks (" << n << " ints, " << rounds << " rounds, best of 5):\n";
+
+    benchmark("std::vector<int>(n, 7)", [&] {
+        for (int r = 0; r < rounds; ++r) { std::vector<int> v(n, 7); sink = sink + v[n - 1]; }
+    });
+    benchmark("InternalArray(n, 7)", [&] {
+        for (int r = 0; r < rounds; ++r) { InternalArray a(n, 7); sink = sink + a[n - 1]; }
+    });
+
+    benchmark("std::vector<int>(n) + write", [&] {
+        for (int r = 0; r < rounds; ++r) {
+            std::vector<int> v(n);
+            for (unsigned int i = 0; i < n; ++i) v[i] = static_cast<int>(i);
+            sink = sink + v[n - 1];
+        }
+    });
+    benchmark("InternalArray(n, uninitialized) + write", [&] {
+        for (int r = 0; r < rounds; ++r) {
+            InternalArray a(n, InternalArray::uninitialized);
+            for (unsigned int i = 0; i < n; ++i) a[i] = static_cast<int>(i);
+            sink = sink + a[n - 1];
+        }
+    });
+
+    std::vector<int> sourceVector(n, 3), targetVector;
+    InternalArray sourceArray(n, 3), targetArray;
+    benchmark("std::vector<int> copy assignment", [&] {
+        for (int r = 0; r < rounds; ++r) { targetVector = sourceVector; sink = sink + targetVector[r]; }
+    });
+    benchmark("InternalArray copy assignment", [&] {
+        for (int r = 0; r < rounds; ++r) { targetArray = sourceArray; sink = sink + targetArray[r]; }
+    });
+
+    benchmark("std::transform on std::vector<int>", [&] {
+        for (int r = 0; r < rounds; ++r) {
+            std::transform(sourceVector.begin(), sourceVector.end(), targetVector.begin(),
+                           [](int x) { return x * 3 + 1; });
+            sink = sink + targetVector[r];
+        }
+    });
+    benchmark("InternalArray::transform", [&] {
+        for (int r = 0; r < rounds; ++r) {
+            targetArray.transform(sourceArray, [](int x) { return x * 3 + 1; });
+            sink = sink + targetArray[r];
+        }
+    });
 
-class InternalArray {
-private:
-    int* m_pArray = nullptr;
-    unsigned int m_uiSize = 0;
+    benchmark("std::vector<int>::push_back", [&] {
+        for (int r = 0; r < rounds; ++r) {
+            std::vector<int> v;
+            for (unsigned int i = 0; i < n; ++i) v.push_back(static_cast<int>(i));
+            sink = sink + v[n - 1];
+        }
+    });
+    benchmark("InternalArray::push_back", [&] {
+        for (int r = 0; r < rounds; ++r) {
+            InternalArray a;
+            for (unsigned int i = 0; i < n; ++i) a.push_back(static_cast<int>(i));
+            sink = sink + a[n - 1];
+        }
+    });
+}
 
-public:
+// Resident set size of the process in bytes (0 if unknown)
+size_t currentRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, residentPages = 0;
+    statm >> pages >> residentPages;
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
 
-    InternalArray() = default;
+// Runs work(threadIndex) on all cores and prints arrays/s and the peak RSS growth while it runs
+template <typename Work>
+void churnBenchmark(const char* name, unsigned long long arraysPerThread, Work work) {
+    unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    size_t baseline = currentRss();
+    std::atomic<bool> done{ false };
+    std::atomic<size_t> peak{ baseline };
+    std::thread monitor([&] {
+        while (!done.load()) {
+            peak.store(std::max(peak.load(), currentRss()));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
 
-    InternalArray(unsigned int newSize) {
-        // According to the C++ standard, allocating an array with size 0 is VALID,
-        // and the returned pointer is unique and non-null. However, implementations
-        // may differ in behavior, and dereferencing such a pointer results in undefined
-        // behavior. To ensure safety and compatibility, handle the case where newSize == 0
-        // explicitly here and in other parts of code.
-        m_pArray = newSize > 0 ? new int[newSize] : nullptr;
-        m_uiSize = newSize;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; ++t) {
+        threads.emplace_back(work, t);
     }
-
-    ~InternalArray() {
-        delete[] m_pArray;
+    for (auto& thread : threads) {
+        thread.join();
     }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    done.store(true);
+    monitor.join();
+
+    double arraysPerSecond = arraysPerThread * threadCount / elapsed.count();
+    std::cout << "  " << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << arraysPerSecond / 1e6 << " M arrays/s"
+              << std::setw(9) << (peak.load() - baseline) / 1048576.0 << " MB peak RSS growth\n";
+}
 
-    InternalArray(const InternalArray& other)
-    {
-        if (this != &other) {
-            m_uiSize = other.m_uiSize;
-            m_pArray = m_uiSize > 0 ? new int[m_uiSize] : nullptr;
-            for (unsigned int i = 0; i < m_uiSize; ++i) {
-                m_pArray[i] = other.m_pArray[i];
+// Allocation cost only: the arrays are created uninitialized.
+// Short-lived arrays per request (created together, dropped together) and
+// long-lived churn (a random live array is replaced) with each allocator backend
+void runAllocatorBenchmarks() {
+    constexpr int requests = 20000;
+    constexpr int arraysPerRequest = 32;
+    constexpr unsigned long long churnSteps = requests * arraysPerRequest;
+    constexpr int liveArrays = 256;
+
+    // sizes from 16 to 4096 ints, the same sequence for every backend
+    auto sizeAt = [](unsigned long long step, unsigned int thread) {
+        unsigned long long x = (step + 1) * 0x9E3779B97F4A7C15ULL ^ thread;
+        return 16u + static_cast<unsigned int>((x >> 40) % 4081);
+    };
+
+    std::cout << "\nAllocator benchmarks (" << std::max(1u, std::thread::hardware_concurrency()) << " threads):\n";
+
+    churnBenchmark("heap, per-request arrays", requests * arraysPerRequest, [&](unsigned int thread) {
+        std::vector<InternalArray> arrays;
+        arrays.reserve(arraysPerRequest);
+        for (int r = 0; r < requests; ++r) {
+            for (int i = 0; i < arraysPerRequest; ++i) {
+                arrays.emplace_back(sizeAt(r * arraysPerRequest + i, thread), InternalArray::uninitialized)[0] = i;
             }
+            arrays.clear();
         }
-    }
-
-    InternalArray(InternalArray&& other) noexcept
-        : m_pArray(other.m_pArray)
-        , m_uiSize(other.m_uiSize)
-    {
-        other.m_pArray = nullptr;
-        other.m_uiSize = 0;
-    }
-
-    InternalArray& operator=(const InternalArray& other)
-    {
-        if (this != &other) {
-            delete[] m_pArray;
-
-            m_uiSize = other.m_uiSize;
-            m_pArray = m_uiSize > 0 ? new int[m_uiSize] : nullptr;
-            for (unsigned int i = 0; i < m_uiSize; ++i) {
-                m_pArray[i] = other.m_pArray[i];
+    });
+    churnBenchmark("arena, per-request arrays", requests * arraysPerRequest, [&](unsigned int thread) {
+        MonotonicArena arena;
+        std::vector<BasicInternalArray<ArenaAllocator>> arrays;
+        arrays.reserve(arraysPerRequest);
+        for (int r = 0; r < requests; ++r) {
+            for (int i = 0; i < arraysPerRequest; ++i) {
+                arrays.emplace_back(sizeAt(r * arraysPerRequest + i, thread), InternalArray::uninitialized,
+                                    ArenaAllocator(arena))[0] = i;
             }
+            arrays.clear();
+            arena.reset();  // the whole request is freed at once
         }
-
-        return *this;
-    }
-
-    InternalArray& operator=(InternalArray&& other) noexcept
-    {
-        if (this != &other) {
-            delete[] m_pArray;
-
-            m_pArray = other.m_pArray;
-            m_uiSize = other.m_uiSize;
-
-            other.m_pArray = nullptr;
-            other.m_uiSize = 0;
+    });
+    churnBenchmark("pool, per-request arrays", requests * arraysPerRequest, [&](unsigned int thread) {
+        std::vector<BasicInternalArray<PoolAllocator>> arrays;
+        arrays.reserve(arraysPerRequest);
+        for (int r = 0; r < requests; ++r) {
+            for (int i = 0; i < arraysPerRequest; ++i) {
+                arrays.emplace_back(sizeAt(r * arraysPerRequest + i, thread), InternalArray::uninitialized)[0] = i;
+            }
+            arrays.clear();
         }
+    });
 
-        return *this;
-    }
-
-    void fill(int value) {
-        for (unsigned int i = 0; i < m_uiSize; ++i) {
-            m_pArray[i] = value;
+    churnBenchmark("heap, long-lived churn", churnSteps, [&](unsigned int thread) {
+        std::vector<InternalArray> arrays(liveArrays);
+        for (unsigned long long step = 0; step < churnSteps; ++step) {
+            arrays[step * 7919 % liveArrays] = InternalArray(sizeAt(step, thread), InternalArray::uninitialized);
         }
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const InternalArray& array) {
-        for (unsigned int i = 0; i < array.m_uiSize; ++i) {
-            os << array.m_pArray[i] << " ";
+    });
+    churnBenchmark("pool, long-lived churn", churnSteps, [&](unsigned int thread) {
+        std::vector<BasicInternalArray<PoolAllocator>> arrays(liveArrays);
+        for (unsigned long long step = 0; step < churnSteps; ++step) {
+            arrays[step * 7919 % liveArrays] =
+                BasicInternalArray<PoolAllocator>(sizeAt(step, thread), InternalArray::uninitialized);
         }
-        return os;
-    }
-};
+    });
+}
 
-int main()
+// hw2: the example; hw2 bench: InternalArray against std::vector, then the allocator backends
+int main(int argc, char* argv[])
 {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        runBenchmarks();
+        runAllocatorBenchmarks();
+        return 0;
+    }
+
     InternalArray array1(5);
     array1.fill(10);
     std::cout << "Array1 (filled): " << array1 << "\n\n";
@@ -1,8 +1,148 @@
 
 #include "my_unique_ptr.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <vector>
+
+// a fixed pool of objects: memory the default delete must never see
+struct Point {
+    int x = 0;
+    int y = 0;
+};
+
+class PointPool {
+private:
+    Point _points[4];
+    bool _used[4] = {};
+
+public:
+    Point* Acquire() {
+        for (int i = 0; i < 4; ++i) {
+            if (!_used[i]) {
+                _used[i] = true;
+                return &_points[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void Return(Point* point) {
+        _used[point - _points] = false;
+        std::cout << "Point returned to pool slot " << (point - _points) << "\n";
+    }
+};
+
+// stateful deleter: remembers the pool the object came from
+struct PoolDeleter {
+    PointPool* pool = nullptr;
+    void operator()(Point* point) const { pool->Return(point); }
+};
+
+// stateless deleters for C resources
+struct FreeDeleter {
+    void operator()(void* ptr) const { std::free(ptr); }
+};
+
+struct FileCloser {
+    void operator()(std::FILE* file) const { std::fclose(file); }
+};
+
+// Times f() over several runs and prints the best one
+template <typename F>
+double benchmark(const char* name, F f) {
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    std::cout << "  " << std::left << std::setw(46) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(8) << best << " ms\n";
+    return best;
+}
+
+// MyUniquePtr vs raw pointers: creation/destruction, access and move
+void runBenchmarks() {
+    constexpr int count = 1 << 22;
+    volatile long long sink = 0;
+
+    std::cout << "\nsizeof: int* = " << sizeof(int*)
+              << ", MyUniquePtr<int> = " << sizeof(MyUniquePtr<int>)
+              << ", MyUniquePtr<int[]> = " << sizeof(MyUniquePtr<int[]>)
+              << ", MyUniquePtr<int, FreeDeleter> = " << sizeof(MyUniquePtr<int, FreeDeleter>)
+              << ", sized array = " << sizeof(MyUniquePtr<int[], MySizedArrayDelete<int>>) << "\n";
+
+    std::cout << "Benchmarks (" << count << " objects, best of 5):\n";
+    benchmark("raw new/delete", [&] {
+        for (int i = 0; i < count; ++i) {
+            int* p = new int(i);
+            sink = sink + *p;
+            delete p;
+        }
+    });
+    benchmark("make_my_unique / destructor", [&] {
+        for (int i = 0; i < count; ++i) {
+            MyUniquePtr<int> p = make_my_unique<int>(i);
+            sink = sink + *p;
+        }
+    });
+
+    std::vector<int*> raw(count);
+    std::vector<MyUniquePtr<int>> owned(count);
+    for (int i = 0; i < count; ++i) {
+        raw[i] = new int(i);
+        owned[i] = make_my_unique<int>(i);
+    }
+    benchmark("sum through int*", [&] {
+        long long sum = 0;
+        for (int* p : raw) sum += *p;
+        sink = sink + sum;
+    });
+    benchmark("sum through MyUniquePtr<int>", [&] {
+        long long sum = 0;
+        for (const auto& p : owned) sum += *p;
+        sink = sink + sum;
+    });
+    benchmark("move int* between vectors (source nulled)", [&] {
+        std::vector<int*> moved(raw.size());
+        for (size_t i = 0; i < raw.size(); ++i) {
+            delete moved[i];  // what a move assignment has to do with the old value
+            moved[i] = raw[i];
+            raw[i] = nullptr;
+        }
+        raw.swap(moved);
+    });
+    benchmark("move MyUniquePtr<int> between vectors", [&] {
+        std::vector<MyUniquePtr<int>> moved(owned.size());
+        for (size_t i = 0; i < owned.size(); ++i) { moved[i] = std::move(owned[i]); }
+        owned.swap(moved);
+    });
+    for (int* p : raw) delete p;
+
+    constexpr std::size_t big = std::size_t(1) << 26;  // 256 MB of ints
+    benchmark("make_my_unique<int[]> (zeroed), 256 MB", [&] {
+        auto array = make_my_unique<int[]>(big);
+        sink = sink + array[big / 2];
+    });
+    benchmark("make_my_unique_for_overwrite<int[]>, 256 MB", [&] {
+        auto array = make_my_unique_for_overwrite<int[]>(big);
+        array[big / 2] = 1;
+        sink = sink + array[big / 2];
+    });
+}
+
+// hw4: the example; hw4 bench: MyUniquePtr against raw pointers
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        runBenchmarks();
+        return 0;
+    }
 
-int main() {
     // single object
     MyUniquePtr<int> singlePtr(new int(42));
     std::cout << "Single object value: " << *singlePtr << "\n";
@@ -29,5 +169,32 @@ int main() {
     // clean up the raw pointer manually
     delete[] rawArray;
 
+    // objects from a pool go back to the pool
+    PointPool pool;
+    {
+        MyUniquePtr<Point, PoolDeleter> point(pool.Acquire(), PoolDeleter{ &pool });
+        point->x = 3;
+        MyUniquePtr<Point, PoolDeleter> other(pool.Acquire(), PoolDeleter{ &pool });
+        point.Swap(other);
+        std::cout << "After swap: point->x = " << point->x << ", other->x = " << other->x << "\n";
+        point.Reset();  // returns the object now, other is returned at the end of the scope
+    }
+
+    // memory and handles from C APIs
+    MyUniquePtr<int, FreeDeleter> fromMalloc(static_cast<int*>(std::malloc(sizeof(int))));
+    *fromMalloc = 7;
+    std::cout << "malloc'ed value: " << *fromMalloc << "\n";
+    MyUniquePtr<std::FILE, FileCloser> file(std::tmpfile());
+    std::cout << "Temporary file " << (file ? "opened" : "not opened") << "\n";
+
+    // arrays that know their size
+    auto sized = make_my_unique_sized<int[]>(3);
+    std::cout << "Sized array of " << sized.Size() << " elements: "
+              << sized[0] << " " << sized[1] << " " << sized[2] << "\n";
+    sized.Reset(new int[5](), 5);  // a sized array takes its new size along with the pointer
+    std::cout << "After Reset: " << sized.Size() << " elements\n";
+    delete[] sized.Release();
+    std::cout << "After Release: " << sized.Size() << " elements\n";
+
     return 0;
 }
@@ -1,119 +1,322 @@
 #ifndef MY_UNIQUE_PTR_H
 #define MY_UNIQUE_PTR_H
 
+#include <cstddef>
+#include <type_traits>
 #include <utility>
 
-template <typename T>  /* single object ownership */
+template <typename T>  /* default deleter: delete */
+struct MyDefaultDelete {
+    MyDefaultDelete() = default;
+
+    // a deleter for Derived can be used where one for Base is expected
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    MyDefaultDelete(const MyDefaultDelete<U>&) {}
+
+    void operator()(T* ptr) const {
+        static_assert(sizeof(T) > 0, "cannot delete an incomplete type");
+        delete ptr;
+    }
+};
+
+template <typename T>  /* default deleter for arrays: delete[] */
+struct MyDefaultDelete<T[]> {
+    void operator()(T* ptr) const {
+        static_assert(sizeof(T) > 0, "cannot delete an incomplete type");
+        delete[] ptr;
+    }
+};
+
+template <typename T>  /* delete[] that also remembers the number of elements */
+struct MySizedArrayDelete {
+    std::size_t size = 0;
+
+    void operator()(T* ptr) const {
+        delete[] ptr;
+    }
+};
+
+// Pointer + deleter. An empty deleter (the default ones, function objects without
+// state) is a base class, so it takes no space: the pointer stays one word.
+template <typename T, typename Deleter,
+          bool = std::is_empty_v<Deleter> && !std::is_final_v<Deleter>>
+class MyPtrStorage : private Deleter {
+private:
+    T* _ptr;
+
+public:
+    MyPtrStorage(T* ptr, const Deleter& deleter) : Deleter(deleter), _ptr(ptr) {}
+    MyPtrStorage(T* ptr, Deleter&& deleter) : Deleter(std::move(deleter)), _ptr(ptr) {}
+
+    T*& ptr() { return _ptr; }
+    T* ptr() const { return _ptr; }
+    Deleter& deleter() { return *this; }
+    const Deleter& deleter() const { return *this; }
+};
+
+template <typename T, typename Deleter>  /* stateful deleter: stored next to the pointer */
+class MyPtrStorage<T, Deleter, false> {
+private:
+    T* _ptr;
+    Deleter _deleter;
+
+public:
+    MyPtrStorage(T* ptr, const Deleter& deleter) : _ptr(ptr), _deleter(deleter) {}
+    MyPtrStorage(T* ptr, Deleter&& deleter) : _ptr(ptr), _deleter(std::move(deleter)) {}
+
+    T*& ptr() { return _ptr; }
+    T* ptr() const { return _ptr; }
+    Deleter& deleter() { return _deleter; }
+    const Deleter& deleter() const { return _deleter; }
+};
+
+template <typename T, typename Deleter = MyDefaultDelete<T>>  /* single object ownership */
 class MyUniquePtr {
 private:
-    T* _ptr;  // pointer to the managed resource
+    MyPtrStorage<T, Deleter> _storage;  // pointer to the managed resource and its deleter
+
+    template <typename U, typename E> friend class MyUniquePtr;
 
 public:
-    MyUniquePtr() : _ptr(nullptr) {}
+    MyUniquePtr() : _storage(nullptr, Deleter()) {}
 
     // constructor accepting a raw pointer
-    explicit MyUniquePtr(T* ptr) : _ptr(ptr) {}
+    explicit MyUniquePtr(T* ptr) : _storage(ptr, Deleter()) {}
+
+    // constructor accepting a raw pointer and the deleter that will release it
+    MyUniquePtr(T* ptr, const Deleter& deleter) : _storage(ptr, deleter) {}
+    MyUniquePtr(T* ptr, Deleter&& deleter) : _storage(ptr, std::move(deleter)) {}
 
     // delete copy constructor to prevent copying
     MyUniquePtr(const MyUniquePtr&) = delete;
 
     // move constructor: transfers ownership
-    MyUniquePtr(MyUniquePtr&& other) noexcept : _ptr(other._ptr) {
-        other._ptr = nullptr;  // nullify the source pointer
+    MyUniquePtr(MyUniquePtr&& other) noexcept
+        : _storage(other._storage.ptr(), std::move(other._storage.deleter())) {
+        other._storage.ptr() = nullptr;  // nullify the source pointer
+    }
+
+    // converting move constructor: MyUniquePtr<Derived> to MyUniquePtr<Base>
+    template <typename U, typename E,
+              typename = std::enable_if_t<std::is_convertible_v<U*, T*> && std::is_convertible_v<E, Deleter>>>
+    MyUniquePtr(MyUniquePtr<U, E>&& other) noexcept
+        : _storage(other._storage.ptr(), std::move(other._storage.deleter())) {
+        other._storage.ptr() = nullptr;
     }
 
     // move assignment operator: transfers ownership
     MyUniquePtr& operator=(MyUniquePtr&& other) noexcept {
-        if (this != &other) {     // prevent self-assignment
-            delete _ptr;          // release existing resource
-            _ptr = other._ptr;    // take ownership
-            other._ptr = nullptr; // nullify the source pointer
+        if (this != &other) {                                  // prevent self-assignment
+            Reset(other.Release());                            // release existing resource, take ownership
+            _storage.deleter() = std::move(other._storage.deleter());
         }
         return *this;
     }
 
     // Destructor: releases the managed resource
     ~MyUniquePtr() {
-        delete _ptr;
+        if (_storage.ptr()) _storage.deleter()(_storage.ptr());
     }
 
     // dereference operator to access the managed object
     T& operator*() const {
-        return *_ptr;
+        return *_storage.ptr();
     }
 
     // member access operator to access the managed object's members
     T* operator->() const {
-        return _ptr;
+        return _storage.ptr();
+    }
+
+    explicit operator bool() const {
+        return _storage.ptr() != nullptr;
     }
 
     // returns the raw pointer (without transferring ownership)
     T* Get() const {
-        return _ptr;
+        return _storage.ptr();
     }
 
+    Deleter& GetDeleter() { return _storage.deleter(); }
+    const Deleter& GetDeleter() const { return _storage.deleter(); }
+
     // transfers ownership and nullifies the internal pointer
     T* Release() {
-        T* temp = _ptr;
-        _ptr = nullptr;
+        T* temp = _storage.ptr();
+        _storage.ptr() = nullptr;
         return temp;
     }
 
+    // takes ownership of ptr and releases the previous resource
+    void Reset(T* ptr = nullptr) {
+        T* old = _storage.ptr();
+        _storage.ptr() = ptr;     // set first: the deleter may reach this object again
+        if (old) _storage.deleter()(old);
+    }
+
+    void Swap(MyUniquePtr& other) noexcept {
+        using std::swap;
+        swap(_storage.ptr(), other._storage.ptr());
+        swap(_storage.deleter(), other._storage.deleter());
+    }
+
     // delete copy assignment operator to prevent copying
     MyUniquePtr& operator=(const MyUniquePtr&) = delete;
 };
 
 
-template <typename T>  /* specialization for arrays */
-class MyUniquePtr<T[]> {
+template <typename T, typename Deleter>  /* specialization for arrays */
+class MyUniquePtr<T[], Deleter> {
 private:
-    T* _ptr;  // pointer to the managed array
+    MyPtrStorage<T, Deleter> _storage;  // pointer to the managed array and its deleter
+
+    // the deleter carries the number of elements (MySizedArrayDelete)
+    static constexpr bool sized = requires(const Deleter& d) { d.size; };
 
 public:
-    MyUniquePtr() : _ptr(nullptr) {}
+    MyUniquePtr() : _storage(nullptr, Deleter()) {}
 
     // constructor accepting a raw array pointer
-    explicit MyUniquePtr(T* ptr) : _ptr(ptr) {}
+    explicit MyUniquePtr(T* ptr) : _storage(ptr, Deleter()) {}
+
+    // constructor accepting a raw array pointer and the deleter that will release it
+    MyUniquePtr(T* ptr, const Deleter& deleter) : _storage(ptr, deleter) {}
+    MyUniquePtr(T* ptr, Deleter&& deleter) : _storage(ptr, std::move(deleter)) {}
 
     // delete copy constructor to prevent copying
     MyUniquePtr(const MyUniquePtr&) = delete;
 
     // move constructor
-    MyUniquePtr(MyUniquePtr&& other) noexcept : _ptr(other._ptr) {
-        other._ptr = nullptr; // nullify the source pointer
+    MyUniquePtr(MyUniquePtr&& other) noexcept
+        : _storage(other._storage.ptr(), std::move(other._storage.deleter())) {
+        other._storage.ptr() = nullptr; // nullify the source pointer
     }
 
     // move assignment operator
     MyUniquePtr& operator=(MyUniquePtr&& other) noexcept {
         if (this != &other) {
-            delete[] _ptr;         // release existing array resource
-            _ptr = other._ptr;     // take ownership
-            other._ptr = nullptr;  // nullify the source pointer
+            // release existing array resource with its own deleter, then take the pointer
+            // and the deleter (with the size, for sized deleters) of other
+            T* old = _storage.ptr();
+            _storage.ptr() = other._storage.ptr();
+            other._storage.ptr() = nullptr;
+            if (old) _storage.deleter()(old);
+            _storage.deleter() = std::move(other._storage.deleter());
         }
         return *this;
     }
 
     ~MyUniquePtr() {
-        delete[] _ptr;
+        if (_storage.ptr()) _storage.deleter()(_storage.ptr());
     }
 
     // subscript operator to access array elements
     T& operator[](std::size_t index) const {
-        return _ptr[index];
+        return _storage.ptr()[index];
+    }
+
+    explicit operator bool() const {
+        return _storage.ptr() != nullptr;
     }
 
     T* Get() const {
-        return _ptr;
+        return _storage.ptr();
+    }
+
+    // number of elements, for deleters that carry it (MySizedArrayDelete)
+    std::size_t Size() const requires sized {
+        return _storage.ptr() ? _storage.deleter().size : 0;
     }
 
+    Deleter& GetDeleter() { return _storage.deleter(); }
+    const Deleter& GetDeleter() const { return _storage.deleter(); }
+
     T* Release() {
-        T* temp = _ptr;
-        _ptr = nullptr;
+        T* temp = _storage.ptr();
+        _storage.ptr() = nullptr;
+        if constexpr (sized) _storage.deleter().size = 0;
         return temp;
     }
 
+    // sized deleters need the new size as well: Reset(ptr, size)
+    void Reset(T* ptr = nullptr) requires (!sized) {
+        T* old = _storage.ptr();
+        _storage.ptr() = ptr;
+        if (old) _storage.deleter()(old);
+    }
+
+    void Reset(std::nullptr_t = nullptr) requires sized {
+        Reset(nullptr, 0);
+    }
+
+    void Reset(T* ptr, std::size_t size) requires sized {
+        T* old = _storage.ptr();
+        _storage.ptr() = ptr;
+        if (old) _storage.deleter()(old);
+        _storage.deleter().size = size;
+    }
+
+    void Swap(MyUniquePtr& other) noexcept {
+        using std::swap;
+        swap(_storage.ptr(), other._storage.ptr());
+        swap(_storage.deleter(), other._storage.deleter());
+    }
+
     // delete copy assignment operator
     MyUniquePtr& operator=(const MyUniquePtr&) = delete;
 };
 
+template <typename T, typename Deleter>
+void swap(MyUniquePtr<T, Deleter>& a, MyUniquePtr<T, Deleter>& b) noexcept {
+    a.Swap(b);
+}
+
+// single object: constructed from args
+template <typename T, typename... Args>
+    requires (!std::is_array_v<T>)
+MyUniquePtr<T> make_my_unique(Args&&... args) {
+    return MyUniquePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+// array of size value-initialized elements (zeros for numbers)
+template <typename T>
+    requires std::is_unbounded_array_v<T>
+MyUniquePtr<T> make_my_unique(std::size_t size) {
+    return MyUniquePtr<T>(new std::remove_extent_t<T>[size]());
+}
+
+// default-initialized: numbers are left uninitialized, for memory that is overwritten anyway
+template <typename T>
+    requires (!std::is_array_v<T>)
+MyUniquePtr<T> make_my_unique_for_overwrite() {
+    return MyUniquePtr<T>(new T);
+}
+
+template <typename T>
+    requires std::is_unbounded_array_v<T>
+MyUniquePtr<T> make_my_unique_for_overwrite(std::size_t size) {
+    return MyUniquePtr<T>(new std::remove_extent_t<T>[size]);
+}
+
+// arrays that know their size: MyUniquePtr<T[], MySizedArrayDelete<T>>::Size()
+template <typename T>
+    requires std::is_unbounded_array_v<T>
+MyUniquePtr<T, MySizedArrayDelete<std::remove_extent_t<T>>> make_my_unique_sized(std::size_t size) {
+    using Element = std::remove_extent_t<T>;
+    return MyUniquePtr<T, MySizedArrayDelete<Element>>(new Element[size](), MySizedArrayDelete<Element>{ size });
+}
+
+template <typename T>
+    requires std::is_unbounded_array_v<T>
+MyUniquePtr<T, MySizedArrayDelete<std::remove_extent_t<T>>> make_my_unique_sized_for_overwrite(std::size_t size) {
+    using Element = std::remove_extent_t<T>;
+    return MyUniquePtr<T, MySizedArrayDelete<Element>>(new Element[size], MySizedArrayDelete<Element>{ size });
+}
+
+// stateless deleters cost nothing, stateful ones exactly their own size
+static_assert(sizeof(MyUniquePtr<int>) == sizeof(int*));
+static_assert(sizeof(MyUniquePtr<int[]>) == sizeof(int*));
+static_assert(sizeof(MyUniquePtr<int[], MySizedArrayDelete<int>>) == sizeof(int*) + sizeof(std::size_t));
+static_assert(sizeof(MyUniquePtr<int, void (*)(int*)>) == 2 * sizeof(void*));
+
 #endif // MY_UNIQUE_PTR_H
@@ -0,0 +1,351 @@
+#ifndef CONTROL_BLOCK_H
+#define CONTROL_BLOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// Counting policies of SharedPtr/WeakPtr
+struct SingleThreaded {};    // plain integers: all copies of one object are used by one thread at a time
+struct BiasedThreadSafe {};  // copies may be made and destroyed on any thread (biased reference counting)
+
+// Shared state of all SharedPtr/WeakPtr copies of one object.
+// weakCount counts the WeakPtrs plus one for all SharedPtrs together, so the block
+// outlives the object exactly as long as some WeakPtr still needs to see use_count() == 0.
+template <typename Policy> class ControlBlock;
+
+template <>
+class ControlBlock<SingleThreaded> {
+private:
+    unsigned uses = 1;
+    unsigned weakCount = 1;
+
+public:
+    void addRef() { ++uses; }
+    void addWeakRef() { ++weakCount; }
+
+    // a new strong reference unless the object is already gone (WeakPtr::lock)
+    bool tryAddRef() {
+        if (uses == 0) return false;
+        ++uses;
+        return true;
+    }
+
+    // drops one strong reference: destroys the object with the last one
+    void release() {
+        if (--uses == 0) {
+            destroyObject();
+            releaseWeak();
+        }
+    }
+
+    void releaseWeak() {
+        if (--weakCount == 0) {
+            destroyBlock();
+        }
+    }
+
+    unsigned useCount() const { return uses; }
+
+protected:
+    virtual ~ControlBlock() = default;
+
+private:
+    virtual void destroyObject() = 0;  // runs the object's destructor
+    virtual void destroyBlock() = 0;   // frees the block (and the object memory if it is inside)
+};
+
+// Biased reference counting: an object is almost always copied and dropped by the
+// thread that created it, so that thread (the owner) keeps its references in a counter
+// only it writes, with plain loads and stores. Other threads use an atomic shared counter.
+//
+// The owner's counter reaching zero merges the two: the block is marked merged and from
+// then on the shared counter alone decides when the object dies. The shared counter may
+// go below zero while the owner still holds references (a copy made by the owner and
+// dropped elsewhere); the first time it does, the block is queued to its owner, which
+// merges it when it next creates a block, calls BiasedOwner::collect() or exits.
+using BiasedControlBlock = ControlBlock<BiasedThreadSafe>;
+
+/* per-thread state of the owner side: queue of blocks waiting to be merged */
+class BiasedOwner {
+public:
+    // the state of the calling thread, or nullptr if it has not created a block yet
+    static BiasedOwner* current() { return currentOwner; }
+
+    // merges the blocks other threads have queued to the calling thread
+    static void collect() {
+        if (currentOwner && currentOwner->pending.load(std::memory_order_relaxed)) {
+            currentOwner->drain();
+        }
+    }
+
+private:
+    friend class ControlBlock<BiasedThreadSafe>;
+
+    // destroys the state at thread exit; blocks still owned then are merged by the
+    // threads that drop them
+    struct ThreadExit {
+        BiasedOwner* owner = nullptr;
+        ~ThreadExit() { if (owner) owner->exit(); }
+    };
+
+    inline static thread_local BiasedOwner* currentOwner = nullptr;
+
+    std::mutex mutex;
+    BiasedControlBlock* queue = nullptr;  // linked through nextQueued, guarded by mutex
+    bool exited = false;                  // guarded by mutex
+    std::atomic<bool> pending{ false };
+    // blocks created by this thread and not merged yet: counted by the thread alone while
+    // it runs, handed over to refs when it exits
+    std::atomic<size_t> unmerged{ 0 };
+    std::atomic<size_t> refs{ 1 };        // the thread + unmerged blocks once it has exited
+
+    // the calling thread's state, counting a new block
+    static BiasedOwner* acquire();
+
+    // a block of this owner has been merged and no longer needs it
+    void blockMerged() {
+        if (currentOwner == this) {
+            unmerged.store(unmerged.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        } else {
+            releaseRef();
+        }
+    }
+
+    void releaseRef() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    void enqueue(BiasedControlBlock* block);  // any thread but the owner
+    void drain();                             // owner thread
+    void exit();                              // owner thread, once
+};
+
+template <>
+class ControlBlock<BiasedThreadSafe> {
+public:
+    ControlBlock()
+        : home(BiasedOwner::acquire())
+        , owner(home)
+    {
+    }
+
+    void addRef() {
+        if (isOwner()) {
+            biased.store(biased.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        } else {
+            shared.fetch_add(countOne, std::memory_order_relaxed);
+        }
+    }
+
+    void addWeakRef() { weakCount.fetch_add(1, std::memory_order_relaxed); }
+
+    bool tryAddRef() {
+        if (isOwner()) {  // not merged yet, so the owner still holds a reference
+            biased.store(biased.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return true;
+        }
+        std::int64_t old = shared.load(std::memory_order_relaxed);
+        do {
+            if ((old & mergedFlag) && (old >> countShift) == 0) return false;
+        } while (!shared.compare_exchange_weak(old, old + countOne, std::memory_order_relaxed));
+        return true;
+    }
+
+    void release() {
+        if (isOwner()) {
+            unsigned count = biased.load(std::memory_order_relaxed) - 1;
+            biased.store(count, std::memory_order_relaxed);
+            if (count == 0) {
+                merge(false);
+            }
+            return;
+        }
+        std::int64_t old = shared.load(std::memory_order_relaxed);
+        std::int64_t desired;
+        do {
+            desired = old - countOne;
+            if (desired < 0) desired |= queuedFlag;  // the owner's counter holds the rest
+        } while (!shared.compare_exchange_weak(old, desired, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed));
+        if (desired == mergedFlag) {
+            destroy();
+        } else if ((desired & queuedFlag) && !(old & queuedFlag)) {
+            home->enqueue(this);
+        }
+    }
+
+    void releaseWeak() {
+        // the last reference cannot gain new ones: skip the locked decrement
+        if (weakCount.load(std::memory_order_acquire) == 1 ||
+            weakCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroyBlock();
+        }
+    }
+
+    // a snapshot: exact only while no other thread changes the counts
+    unsigned useCount() const {
+        std::int64_t count = biased.load(std::memory_order_relaxed) +
+                             (shared.load(std::memory_order_acquire) >> countShift);
+        return count > 0 ? static_cast<unsigned>(count) : 0;
+    }
+
+protected:
+    // only reached before merging if the object's constructor threw
+    virtual ~ControlBlock() {
+        if (owner.load(std::memory_order_relaxed)) home->blockMerged();
+    }
+
+private:
+    friend class BiasedOwner;
+
+    // shared = references of other threads * countOne + queuedFlag + mergedFlag
+    static constexpr std::int64_t mergedFlag = 1;
+    static constexpr std::int64_t queuedFlag = 2;
+    static constexpr int countShift = 2;
+    static constexpr std::int64_t countOne = std::int64_t(1) << countShift;
+
+    BiasedOwner* home;                    // the creating thread's state, where the block is queued
+    std::atomic<BiasedOwner*> owner;      // home until merged, then nullptr
+    std::atomic<unsigned> biased{ 1 };    // the owner's references: only the owner thread writes it
+    std::atomic<std::int64_t> shared{ 0 };
+    std::atomic<unsigned> weakCount{ 1 };
+    BiasedControlBlock* nextQueued = nullptr;
+
+    bool isOwner() const {
+        BiasedOwner* self = BiasedOwner::current();
+        return self && owner.load(std::memory_order_relaxed) == self;
+    }
+
+    // moves the owner's references into the shared counter; runs on the owner thread,
+    // or on any thread once the owner has exited. dequeued: the block was taken off the queue.
+    void merge(bool dequeued) {
+        bool wasMerged = owner.load(std::memory_order_relaxed) == nullptr;
+        std::int64_t ownerRefs = std::int64_t(biased.load(std::memory_order_relaxed)) << countShift;
+        biased.store(0, std::memory_order_relaxed);
+        owner.store(nullptr, std::memory_order_relaxed);
+
+        std::int64_t old = shared.load(std::memory_order_relaxed);
+        std::int64_t desired;
+        do {
+            desired = (old + ownerRefs) | mergedFlag;
+            if (dequeued) desired &= ~queuedFlag;
+        } while (!shared.compare_exchange_weak(old, desired, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed));
+        if (!wasMerged) {
+            home->blockMerged();
+        }
+        // while queued, the block is destroyed only after it has been taken off the queue
+        if (desired == mergedFlag) {
+            destroy();
+        }
+    }
+
+    void destroy() {
+        destroyObject();
+        releaseWeak();
+    }
+
+    virtual void destroyObject() = 0;
+    virtual void destroyBlock() = 0;
+};
+
+inline BiasedOwner* BiasedOwner::acquire() {
+    if (!currentOwner) {
+        thread_local ThreadExit threadExit;
+        currentOwner = new BiasedOwner;
+        threadExit.owner = currentOwner;
+    } else {
+        collect();
+    }
+    BiasedOwner* self = currentOwner;
+    self->unmerged.store(self->unmerged.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return self;
+}
+
+inline void BiasedOwner::enqueue(BiasedControlBlock* block) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!exited) {
+            block->nextQueued = queue;
+            queue = block;
+            pending.store(true, std::memory_order_relaxed);
+            return;
+        }
+    }
+    // the owner is gone and will not touch its counter again: merge here
+    block->merge(true);
+}
+
+inline void BiasedOwner::drain() {
+    BiasedControlBlock* block;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        block = queue;
+        queue = nullptr;
+        pending.store(false, std::memory_order_relaxed);
+    }
+    while (block) {
+        BiasedControlBlock* next = block->nextQueued;  // merge may free the block
+        block->merge(true);
+        block = next;
+    }
+}
+
+inline void BiasedOwner::exit() {
+    drain();
+    // other threads merge and release blocks only after seeing exited, so refs is complete by then
+    refs.fetch_add(unmerged.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    currentOwner = nullptr;  // from here on this thread counts through the shared counters too
+    BiasedControlBlock* block;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        exited = true;
+        block = queue;  // queued since the drain
+        queue = nullptr;
+    }
+    while (block) {
+        BiasedControlBlock* next = block->nextQueued;
+        block->merge(true);
+        block = next;
+    }
+    releaseRef();
+}
+
+template <typename T, typename Policy>  /* object allocated separately with new */
+class PointerControlBlock final : public ControlBlock<Policy> {
+private:
+    T* ptr;
+
+public:
+    explicit PointerControlBlock(T* rawPtr) : ptr(rawPtr) {}
+
+private:
+    void destroyObject() override { delete ptr; }
+    void destroyBlock() override { delete this; }
+};
+
+template <typename T, typename Policy>  /* object stored inside the block: one allocation, one cache line for small objects */
+class InplaceControlBlock final : public ControlBlock<Policy> {
+private:
+    alignas(T) unsigned char storage[sizeof(T)];
+
+public:
+    template <typename... Args>
+    explicit InplaceControlBlock(Args&&... args) {
+        ::new (static_cast<void*>(storage)) T(std::forward<Args>(args)...);
+    }
+
+    T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+
+private:
+    void destroyObject() override { object()->~T(); }
+    void destroyBlock() override { delete this; }
+};
+
+#endif // CONTROL_BLOCK_H
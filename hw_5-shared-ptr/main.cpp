@@ -1,20 +1,33 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "shared_ptr.h"
+
+// The original two-allocation version, kept as the benchmark baseline
 template <typename T>
-class SharedPtr {
+class LegacySharedPtr {
 private:
     T* ptr;               // Raw pointer to the managed object
     unsigned* refCount;   // Pointer to the reference count
 
 public:
     // Constructor: Initializes with a raw pointer
-    explicit SharedPtr(T* rawPtr = nullptr)
+    explicit LegacySharedPtr(T* rawPtr = nullptr)
         : ptr(rawPtr)
         , refCount(rawPtr ? new unsigned(1) : nullptr)
     {}
 
     // Copy constructor: Increments the reference count
-    SharedPtr(const SharedPtr& other)
+    LegacySharedPtr(const LegacySharedPtr& other)
         : ptr(other.ptr)
         , refCount(other.refCount)
     {
@@ -23,18 +36,18 @@ public:
     }
 
     // Destructor: Decrements the reference count and deletes resources if needed
-    ~SharedPtr() {
+    ~LegacySharedPtr() {
         release();
     }
 
     // Overloaded assignment operator
-    SharedPtr& operator=(const SharedPtr& other) {
+    LegacySharedPtr& operator=(const LegacySharedPtr& other) {
         if (this != &other) { // Avoid self-assignment
+            if (other.refCount)
+                ++(*other.refCount); // before release: other may be owned by our object
             release();        // Release the current resource
             ptr = other.ptr;
             refCount = other.refCount;
-            if (refCount)
-                ++(*refCount); // Increment reference count
         }
         return *this;
     }
@@ -74,8 +87,286 @@ private:
     }
 };
 
-// Example usage
-int main() {
+// Payload of the container benchmarks: small enough that the count and the object share a cache line
+struct Item {
+    int key;
+    int value;
+};
+
+// Times f() over several runs and prints the best one
+template <typename F>
+void benchmark(const char* name, F f) {
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    std::cout << "  " << std::left << std::setw(48) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(8) << best << " ms\n";
+}
+
+// Creation, copies and container workloads of one pointer type
+template <typename Ptr, typename Make>
+void benchmarkPointer(const std::string& name, Make make) {
+    constexpr int count = 1 << 20;
+    volatile long long sink = 0;
+
+    benchmark((name + ": create + destroy").c_str(), [&] {
+        for (int i = 0; i < count; ++i) {
+            Ptr p = make(i);
+            sink = sink + p->key;
+        }
+    });
+
+    std::vector<Ptr> items;
+    items.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        items.push_back(make(static_cast<int>((i * 2654435761u) % count)));
+    }
+    benchmark((name + ": copy vector").c_str(), [&] {
+        std::vector<Ptr> copy = items;
+        sink = sink + copy.back()->value;
+    });
+    benchmark((name + ": pass by value").c_str(), [&] {
+        long long sum = 0;
+        auto byValue = [](Ptr p) { return p->value; };
+        for (const Ptr& p : items) sum += byValue(p);
+        sink = sink + sum;
+    });
+    benchmark((name + ": sort copy by key").c_str(), [&] {
+        std::vector<Ptr> copy = items;
+        std::sort(copy.begin(), copy.end(), [](const Ptr& a, const Ptr& b) { return a->key < b->key; });
+        sink = sink + copy.front()->key;
+    });
+}
+
+void runBenchmarks() {
+    std::cout << "\nBenchmarks (" << (1 << 20) << " objects, best of 5):\n";
+    benchmarkPointer<LegacySharedPtr<Item>>("legacy SharedPtr(new)", [](int i) {
+        return LegacySharedPtr<Item>(new Item{ i, i });
+    });
+    benchmarkPointer<SharedPtr<Item>>("SharedPtr(new)", [](int i) {
+        return SharedPtr<Item>(new Item{ i, i });
+    });
+    benchmarkPointer<SharedPtr<Item>>("makeShared", [](int i) {
+        return makeShared<Item>(Item{ i, i });
+    });
+    benchmarkPointer<SharedPtr<Item, BiasedThreadSafe>>("makeShared<BiasedThreadSafe>", [](int i) {
+        return makeShared<Item, BiasedThreadSafe>(Item{ i, i });
+    });
+    benchmarkPointer<std::shared_ptr<Item>>("std::make_shared", [](int i) {
+        return std::make_shared<Item>(Item{ i, i });
+    });
+}
+
+// copies made and dropped by several threads at once
+template <typename Ptr>
+void benchmarkThreads(const std::string& name, const Ptr& object, unsigned threadCount) {
+    constexpr int copies = 1 << 20;
+    auto copyLoop = [](const Ptr& source) {
+        for (int i = 0; i < copies; ++i) {
+            Ptr copy = source;
+            std::atomic_signal_fence(std::memory_order_seq_cst);  // keep the copy
+        }
+    };
+
+    // every thread copies the same object: the owner (this thread) and the others
+    benchmark((name + ": one object, " + std::to_string(threadCount) + " threads").c_str(), [&] {
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < threadCount; ++t) {
+            threads.emplace_back(copyLoop, std::cref(object));
+        }
+        copyLoop(object);
+        for (std::thread& thread : threads) thread.join();
+    });
+}
+
+void runThreadBenchmarks() {
+    unsigned threadCount = std::max(2u, std::thread::hardware_concurrency());
+    std::cout << "\nThread benchmarks (" << (1 << 20) << " copies per thread, best of 5):\n";
+
+    Item item{ 1, 1 };
+    benchmark("raw pointer copies (baseline)", [&] {
+        Item* volatile source = &item;
+        for (int i = 0; i < (1 << 20); ++i) {
+            Item* copy = source;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            (void)copy;
+        }
+    });
+
+    // single thread: biased counting is plain increments, std::shared_ptr uses locked instructions
+    auto biased = makeShared<Item, BiasedThreadSafe>(Item{ 1, 1 });
+    auto standard = std::make_shared<Item>(Item{ 1, 1 });
+    benchmarkThreads("BiasedThreadSafe", biased, 1);
+    benchmarkThreads("std::shared_ptr", standard, 1);
+
+    // contended: the other threads share one atomic counter in both cases
+    benchmarkThreads("BiasedThreadSafe", biased, threadCount);
+    benchmarkThreads("std::shared_ptr", standard, threadCount);
+}
+
+// Counts live objects of the stress test
+struct Tracked {
+    static inline std::atomic<long> alive{ 0 };
+    int value;
+
+    explicit Tracked(int v) : value(v) { alive.fetch_add(1, std::memory_order_relaxed); }
+    ~Tracked() { alive.fetch_sub(1, std::memory_order_relaxed); }
+};
+
+// Objects created on several threads are copied, locked through WeakPtrs, handed over and
+// dropped on other threads, while their creators drop their own copies at random moments
+// and some of them exit first. Every object must be destroyed exactly once at the end.
+// Build with -fsanitize=thread (gcc/clang) to check the counting for data races.
+bool runStressTest() {
+    using Ptr = SharedPtr<Tracked, BiasedThreadSafe>;
+    constexpr int producers = 3;
+    constexpr int objectsPerProducer = 20000;
+    constexpr unsigned workers = 4;
+
+    std::mutex mailboxMutex;
+    std::deque<std::pair<Ptr, int>> mailbox;  // object and the number of remaining hand-overs
+    std::atomic<int> producersLeft{ producers };
+    std::atomic<long> handovers{ 0 };
+
+    auto post = [&](Ptr p, int hops) {
+        std::lock_guard<std::mutex> lock(mailboxMutex);
+        mailbox.emplace_back(std::move(p), hops);
+    };
+
+    auto produce = [&](int seed) {
+        std::vector<Ptr> kept;
+        unsigned random = static_cast<unsigned>(seed) * 2654435761u + 1;
+        for (int i = 0; i < objectsPerProducer; ++i) {
+            Ptr p = makeShared<Tracked, BiasedThreadSafe>(i);
+            random = random * 1664525u + 1013904223u;
+            post(p, static_cast<int>(random >> 29));  // a copy: the shared counter goes below zero
+            if (random & 0x100) kept.push_back(p);    // sometimes keep ours for a while
+            if (kept.size() > 64) kept.erase(kept.begin(), kept.begin() + 32);
+            if ((i & 255) == 0) BiasedOwner::collect();
+        }
+        producersLeft.fetch_sub(1);
+    };
+
+    auto work = [&] {
+        long sum = 0;
+        for (;;) {
+            std::pair<Ptr, int> message;
+            {
+                std::lock_guard<std::mutex> lock(mailboxMutex);
+                if (!mailbox.empty()) {
+                    message = std::move(mailbox.front());
+                    mailbox.pop_front();
+                }
+            }
+            if (!message.first) {
+                if (producersLeft.load() == 0) {
+                    std::lock_guard<std::mutex> lock(mailboxMutex);
+                    if (mailbox.empty()) break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            Ptr copy = message.first;
+            WeakPtr<Tracked, BiasedThreadSafe> weak = copy;
+            copy.reset();
+            if (Ptr locked = weak.lock()) sum += locked->value;
+            if (message.second > 0) {
+                handovers.fetch_add(1, std::memory_order_relaxed);
+                post(std::move(message.first), message.second - 1);
+            }
+        }
+        return sum;
+    };
+
+    {
+        std::vector<std::thread> threads;
+        for (unsigned w = 0; w < workers; ++w) threads.emplace_back(work);
+        for (int p = 1; p < producers; ++p) threads.emplace_back(produce, p);  // exit before the workers
+        produce(0);  // this thread stays alive and collects its queue below
+        for (std::thread& thread : threads) thread.join();
+    }
+    BiasedOwner::collect();
+
+    long left = Tracked::alive.load();
+    std::cout << "\nStress test: " << producers * objectsPerProducer << " objects, "
+              << handovers.load() << " hand-overs between threads, still alive: " << left << std::endl;
+    return left == 0;
+}
+
+// A singly linked list dropped front to front with head = std::move(head->next) and with
+// head = head->next: every assignment destroys the node that holds its source. Build with
+// -fsanitize=address to check that the source is read before the node is freed.
+bool runListTest() {
+    struct Node {
+        Tracked value;
+        SharedPtr<Node> next;
+
+        Node(int v, SharedPtr<Node> rest) : value(v), next(std::move(rest)) {}
+    };
+    constexpr int length = 1000;
+
+    long before = Tracked::alive.load();
+    auto build = [] {
+        SharedPtr<Node> head;
+        for (int i = 0; i < length; ++i) {
+            SharedPtr<Node> node = makeShared<Node>(i, std::move(head));
+            head = std::move(node);
+        }
+        return head;
+    };
+    long moved = 0;
+    for (SharedPtr<Node> head = build(); head; head = std::move(head->next)) {
+        moved += head->value.value;
+    }
+    long copied = 0;
+    for (SharedPtr<Node> head = build(); head; head = head->next) {
+        copied += head->value.value;
+    }
+
+    long expected = static_cast<long>(length) * (length - 1) / 2;
+    bool ok = moved == expected && copied == expected && Tracked::alive.load() == before;
+    std::cout << "\nList test: " << length << " nodes dropped one by one (move and copy), "
+              << (ok ? "all destroyed" : "FAILED") << std::endl;
+    return ok;
+}
+
+// An object that owns itself through a member and lets go with self.reset(): the last
+// reference is dropped from inside the object it destroys.
+bool runSelfResetTest() {
+    struct Session {
+        Tracked value{ 0 };
+        SharedPtr<Session> self;
+        WeakPtr<Session> weakSelf;
+    };
+
+    long before = Tracked::alive.load();
+    Session* session = nullptr;
+    {
+        SharedPtr<Session> owner = makeShared<Session>();
+        owner->self = owner;
+        owner->weakSelf = owner;
+        session = owner.get();
+    }
+    bool aliveBefore = Tracked::alive.load() == before + 1;  // kept alive by its own member
+    session->self.reset();
+
+    bool ok = aliveBefore && Tracked::alive.load() == before;
+    std::cout << "Self-reset test: " << (ok ? "destroyed once" : "FAILED") << std::endl;
+    return ok;
+}
+
+// hw5: the example and the lifetime tests; hw5 bench: the pointer benchmarks
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        runBenchmarks();
+        runThreadBenchmarks();
+        return 0;
+    }
+
     SharedPtr<int> sp1(new int(42));
     std::cout << "Value: " << *sp1 << ", Use count: " << sp1.use_count() << std::endl;
 
@@ -86,5 +377,34 @@ int main() {
     sp3 = sp1; // Assignment operator
     std::cout << "Value: " << *sp3 << ", Use count: " << sp3.use_count() << std::endl;
 
-    return 0;
+    // Object and counts in one allocation
+    SharedPtr<std::string> text = makeShared<std::string>("shared text");
+    SharedPtr<std::string> moved = std::move(text); // Move constructor: no count change
+    std::cout << "Moved: " << *moved << ", Use count: " << moved.use_count()
+              << ", source valid: " << text.isValid() << std::endl;
+
+    // Weak reference: does not keep the object alive
+    WeakPtr<std::string> weak = moved;
+    if (SharedPtr<std::string> locked = weak.lock()) {
+        std::cout << "Locked: " << *locked << ", Use count: " << locked.use_count() << std::endl;
+    }
+    moved.reset();
+    std::cout << "After reset, weak expired: " << weak.expired() << std::endl;
+
+    // Aliasing: a pointer to a member that keeps the whole object alive
+    SharedPtr<Item> item = makeShared<Item>(Item{ 1, 100 });
+    SharedPtr<int> value(item, &item->value);
+    item.reset();
+    std::cout << "Member through alias: " << *value << ", Use count: " << value.use_count() << std::endl;
+
+    // Thread-safe counting: copies may live on other threads
+    SharedPtr<int, BiasedThreadSafe> counter = makeShared<int, BiasedThreadSafe>(7);
+    std::thread reader([copy = counter] { std::cout << "From another thread: " << *copy << std::endl; });
+    reader.join();
+    std::cout << "After the thread, Use count: " << counter.use_count() << std::endl;
+
+    bool listOk = runListTest() && runSelfResetTest();
+    bool stressOk = runStressTest();
+
+    return listOk && stressOk ? 0 : 1;
 }
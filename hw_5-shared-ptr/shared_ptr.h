@@ -0,0 +1,279 @@
+#ifndef SHARED_PTR_H
+#define SHARED_PTR_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "control_block.h"
+
+template <typename T, typename Policy = SingleThreaded> class WeakPtr;
+
+// Policy: SingleThreaded or BiasedThreadSafe (see control_block.h)
+template <typename T, typename Policy = SingleThreaded>
+class SharedPtr {
+private:
+    T* ptr;                         // Raw pointer to the managed object (or a part of it, see aliasing)
+    ControlBlock<Policy>* control;  // Reference counts, shared by all copies
+
+    template <typename U, typename P> friend class SharedPtr;
+    template <typename U, typename P> friend class WeakPtr;
+    template <typename U, typename P, typename... Args> friend SharedPtr<U, P> makeShared(Args&&... args);
+
+    SharedPtr(T* rawPtr, ControlBlock<Policy>* block) : ptr(rawPtr), control(block) {}
+
+public:
+    // Constructor: Initializes with a raw pointer
+    explicit SharedPtr(T* rawPtr = nullptr)
+        : ptr(rawPtr)
+        , control(nullptr)
+    {
+        if (rawPtr) {
+            try {
+                control = new PointerControlBlock<T, Policy>(rawPtr);
+            } catch (...) {
+                delete rawPtr;  // the object must not leak if the block cannot be allocated
+                throw;
+            }
+        }
+    }
+
+    // Copy constructor: Increments the reference count
+    SharedPtr(const SharedPtr& other)
+        : ptr(other.ptr)
+        , control(other.control)
+    {
+        if (control)
+            control->addRef();
+    }
+
+    // Move constructor: takes over the reference, the count does not change
+    SharedPtr(SharedPtr&& other) noexcept
+        : ptr(other.ptr)
+        , control(other.control)
+    {
+        other.ptr = nullptr;
+        other.control = nullptr;
+    }
+
+    // SharedPtr<Derived> to SharedPtr<Base>
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    SharedPtr(const SharedPtr<U, Policy>& other)
+        : ptr(other.ptr)
+        , control(other.control)
+    {
+        if (control)
+            control->addRef();
+    }
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    SharedPtr(SharedPtr<U, Policy>&& other) noexcept
+        : ptr(other.ptr)
+        , control(other.control)
+    {
+        other.ptr = nullptr;
+        other.control = nullptr;
+    }
+
+    // Aliasing constructor: shares ownership of owner's object but points to member
+    // (e.g. a field of it); the whole object lives as long as this pointer
+    template <typename U>
+    SharedPtr(const SharedPtr<U, Policy>& owner, T* member)
+        : ptr(member)
+        , control(owner.control)
+    {
+        if (control)
+            control->addRef();
+    }
+
+    // Destructor: Decrements the reference count and deletes resources if needed
+    ~SharedPtr() {
+        release();
+    }
+
+    // Overloaded assignment operator
+    SharedPtr& operator=(const SharedPtr& other) {
+        if (this != &other) { // Avoid self-assignment
+            // take a reference to other's pair before release: other may be owned by
+            // our object (head = head->next)
+            T* newPtr = other.ptr;
+            ControlBlock<Policy>* newControl = other.control;
+            if (newControl)
+                newControl->addRef();
+            release();        // Release the current resource
+            ptr = newPtr;
+            control = newControl;
+        }
+        return *this;
+    }
+
+    SharedPtr& operator=(SharedPtr&& other) noexcept {
+        if (this != &other) {
+            // take other's pair before release: other may be owned by our object
+            // (head = std::move(head->next))
+            T* newPtr = other.ptr;
+            ControlBlock<Policy>* newControl = other.control;
+            other.ptr = nullptr;
+            other.control = nullptr;
+            release();
+            ptr = newPtr;
+            control = newControl;
+        }
+        return *this;
+    }
+
+    // Dereference operator: Returns a reference to the managed object
+    T& operator*() const {
+        return *ptr;
+    }
+
+    // Member access operator: Returns the raw pointer
+    T* operator->() const {
+        return ptr;
+    }
+
+    T* get() const {
+        return ptr;
+    }
+
+    // Check if the pointer is valid
+    bool isValid() const {
+        return ptr != nullptr;
+    }
+
+    explicit operator bool() const {
+        return ptr != nullptr;
+    }
+
+    // Get the current reference count
+    unsigned use_count() const {
+        return control ? control->useCount() : 0;
+    }
+
+    void reset() {
+        release();
+    }
+
+    void swap(SharedPtr& other) noexcept {
+        std::swap(ptr, other.ptr);
+        std::swap(control, other.control);
+    }
+
+private:
+    // Releases the ownership of the current resource
+    // The members are cleared first: this pointer may be part of the object that the
+    // last reference deletes (node->self.reset()).
+    void release() {
+        ControlBlock<Policy>* old = control;
+        ptr = nullptr;
+        control = nullptr;
+        if (old) {
+            old->release();  // deletes the object with the last reference
+        }
+    }
+};
+
+template <typename T, typename Policy>  /* non-owning reference that can tell whether the object still exists */
+class WeakPtr {
+private:
+    T* ptr;
+    ControlBlock<Policy>* control;
+
+public:
+    WeakPtr() : ptr(nullptr), control(nullptr) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    WeakPtr(const SharedPtr<U, Policy>& shared)
+        : ptr(shared.ptr)
+        , control(shared.control)
+    {
+        if (control)
+            control->addWeakRef();
+    }
+
+    WeakPtr(const WeakPtr& other)
+        : ptr(other.ptr)
+        , control(other.control)
+    {
+        if (control)
+            control->addWeakRef();
+    }
+
+    WeakPtr(WeakPtr&& other) noexcept
+        : ptr(other.ptr)
+        , control(other.control)
+    {
+        other.ptr = nullptr;
+        other.control = nullptr;
+    }
+
+    ~WeakPtr() {
+        release();
+    }
+
+    WeakPtr& operator=(const WeakPtr& other) {
+        if (this != &other) {
+            T* newPtr = other.ptr;  // before release, as in SharedPtr
+            ControlBlock<Policy>* newControl = other.control;
+            if (newControl)
+                newControl->addWeakRef();
+            release();
+            ptr = newPtr;
+            control = newControl;
+        }
+        return *this;
+    }
+
+    WeakPtr& operator=(WeakPtr&& other) noexcept {
+        if (this != &other) {
+            T* newPtr = other.ptr;  // before release, as in SharedPtr
+            ControlBlock<Policy>* newControl = other.control;
+            other.ptr = nullptr;
+            other.control = nullptr;
+            release();
+            ptr = newPtr;
+            control = newControl;
+        }
+        return *this;
+    }
+
+    unsigned use_count() const {
+        return control ? control->useCount() : 0;
+    }
+
+    bool expired() const {
+        return use_count() == 0;
+    }
+
+    // a SharedPtr to the object, or an empty one if it has been destroyed
+    SharedPtr<T, Policy> lock() const {
+        if (control && control->tryAddRef()) {
+            return SharedPtr<T, Policy>(ptr, control);
+        }
+        return SharedPtr<T, Policy>();
+    }
+
+    void reset() {
+        release();
+    }
+
+private:
+    void release() {
+        ControlBlock<Policy>* old = control;  // cleared first, as in SharedPtr
+        ptr = nullptr;
+        control = nullptr;
+        if (old) {
+            old->releaseWeak();
+        }
+    }
+};
+
+// Creates the object and its reference counts with a single allocation:
+// makeShared<T>(args...) or makeShared<T, BiasedThreadSafe>(args...)
+template <typename T, typename Policy = SingleThreaded, typename... Args>
+SharedPtr<T, Policy> makeShared(Args&&... args) {
+    auto* block = new InplaceControlBlock<T, Policy>(std::forward<Args>(args)...);
+    return SharedPtr<T, Policy>(block->object(), block);
+}
+
+#endif // SHARED_PTR_H
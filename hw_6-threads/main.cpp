@@ -2,47 +2,142 @@
 #include <vector>
 #include <thread>
 #include <algorithm>  // for std::for_each
+#include <chrono>
+#include <iomanip>
+#include <new>
+#include <span>
+#include <sstream>
+#include <string>
 
-// Function to increment elements in a specific range
-void incrementRange(std::vector<int>& vec, size_t start, size_t end, int incrementValue) {
-    // Increment each element in the assigned range
-    for (size_t i = start; i < end; ++i) {
-        vec[i] += incrementValue;
+#include "parallel_for.h"
+
+// Smallest chunk handed to a thread: below this, waking one costs more than the work
+constexpr size_t grainSize = 16 * 1024;
+
+// Function to increment elements in a specific range, on the threads of the pool
+void incrementRange(std::vector<int>& vec, size_t start, size_t end, int incrementValue,
+                    Schedule schedule = Schedule::Static, ThreadPool& pool = ThreadPool::global()) {
+    parallel_for(std::span<int>(vec).subspan(start, end - start), grainSize, [incrementValue](std::span<int> chunk) {
+        // Increment each element in the assigned chunk
+        for (int& value : chunk) {
+            value += incrementValue;
+        }
+    }, schedule, pool);
+}
+
+// The original version: new threads for every call, each with an equal contiguous chunk
+void incrementWithNewThreads(std::vector<int>& vec, int incrementValue, size_t numThreads) {
+    size_t chunkSize = (vec.size() + numThreads - 1) / numThreads;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t) {
+        size_t start = std::min(t * chunkSize, vec.size());
+        size_t end = std::min(start + chunkSize, vec.size());
+        threads.emplace_back([&vec, start, end, incrementValue] {
+            for (size_t i = start; i < end; ++i) {
+                vec[i] += incrementValue;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
     }
 }
 
-int main() {
-    // Create a vector with some initial values
-    const size_t vectorSize = 100; // Total size of the vector
-    std::vector<int> vec(vectorSize, 0); // Initialize all elements to 0
+// Best time of f() over runs, in milliseconds
+template <typename F>
+double bestTime(int runs, F f) {
+    double best = 1e300;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
 
-    int incrementValue = 5; // Value to increment each element
-    size_t numThreads = 4;  // Number of threads to use
+// Thread counts to measure: powers of two up to the number of hardware threads (at least 4)
+std::vector<unsigned> threadCounts() {
+    unsigned limit = std::max(ThreadPool::defaultConcurrency(), 4u);
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < limit; t *= 2) counts.push_back(t);
+    counts.push_back(limit);
+    return counts;
+}
 
-    // Determine the size of each chunk
-    size_t chunkSize = (vectorSize + numThreads - 1) / numThreads; // Ensure all elements are processed
+// Per-call overhead on a small vector: thread creation against waking pool threads
+void benchmarkLaunchCost() {
+    constexpr int calls = 2000;
+    std::vector<int> vec(4 * grainSize, 0);
+    std::cout << "\nLaunch cost (" << vec.size() << " elements, microseconds per call, best of 5):\n";
+    std::cout << "  threads   new threads   pool static   pool guided\n";
 
-    // Vector to hold thread objects
-    std::vector<std::thread> threads;
+    for (unsigned threads : threadCounts()) {
+        ThreadPool pool(threads);
+        double created = bestTime(5, [&] {
+            for (int i = 0; i < calls / 10; ++i) incrementWithNewThreads(vec, 1, threads);
+        }) * 1000 / (calls / 10);
+        double pooled = bestTime(5, [&] {
+            for (int i = 0; i < calls; ++i) incrementRange(vec, 0, vec.size(), 1, Schedule::Static, pool);
+        }) * 1000 / calls;
+        double guided = bestTime(5, [&] {
+            for (int i = 0; i < calls; ++i) incrementRange(vec, 0, vec.size(), 1, Schedule::Guided, pool);
+        }) * 1000 / calls;
+        std::cout << std::fixed << std::setprecision(2) << "  " << std::setw(7) << threads
+                  << std::setw(14) << created << std::setw(14) << pooled << std::setw(14) << guided << "\n";
+    }
+}
 
-    // Launch threads
-    for (size_t t = 0; t < numThreads; ++t) {
-        size_t start = t * chunkSize; // Start index for this thread
-        size_t end = std::min(start + chunkSize, vectorSize); // End index for this thread
+// Throughput on a large vector: each element is read and written once
+void benchmarkScaling(size_t elements) {
+    std::vector<int> vec;
+    try {
+        vec.assign(elements, 0);
+    } catch (const std::bad_alloc&) {
+        std::cout << "\nNot enough memory for " << elements << " elements\n";
+        return;
+    }
+    double gigabytes = 2.0 * elements * sizeof(int) / 1e9;
+    std::cout << "\nScaling (" << elements << " elements, ms and GB/s, best of 3):\n";
+    std::cout << "  threads          new threads            pool static            pool guided\n";
 
-        // Create and start the thread
-        threads.emplace_back(incrementRange, std::ref(vec), start, end, incrementValue);
+    auto cell = [gigabytes](double ms) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(1) << std::setw(9) << ms << std::setw(7) << gigabytes / (ms / 1000) << " GB/s";
+        return text.str();
+    };
+    for (unsigned threads : threadCounts()) {
+        ThreadPool pool(threads);
+        double created = bestTime(3, [&] { incrementWithNewThreads(vec, 1, threads); });
+        double pooled = bestTime(3, [&] { incrementRange(vec, 0, vec.size(), 1, Schedule::Static, pool); });
+        double guided = bestTime(3, [&] { incrementRange(vec, 0, vec.size(), 1, Schedule::Guided, pool); });
+        std::cout << "  " << std::setw(7) << threads << cell(created) << cell(pooled) << cell(guided) << "\n";
     }
+}
 
-    // Wait for all threads to finish
-    for (auto& thread : threads) {
-        thread.join();
+// hw6: the example; hw6 bench [elements]: benchmarks on a vector of elements ints (default 10^9)
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        size_t elements = argc > 2 ? std::stoull(argv[2]) : 1'000'000'000;
+        benchmarkLaunchCost();
+        benchmarkScaling(elements);
+        return 0;
     }
 
+    // Create a vector with some initial values
+    const size_t vectorSize = 100; // Total size of the vector
+    std::vector<int> vec(vectorSize, 0); // Initialize all elements to 0
+
+    int incrementValue = 5; // Value to increment each element
+
+    // The pool threads split the vector into cache-line aligned chunks
+    incrementRange(vec, 0, vectorSize, incrementValue);
+
     // Output the updated vector
     for (const auto& value : vec) {
         std::cout << value << " ";
     }
+    std::cout << std::endl;
 
     return 0;
 }
@@ -0,0 +1,114 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "thread_pool.h"
+
+constexpr size_t cacheLineSize = 64;
+
+enum class Schedule {
+    Static,  // one contiguous chunk per thread: no coordination, best for uniform work
+    Guided,  // chunks taken from a shared cursor, shrinking as the work runs out: balances uneven work
+};
+
+struct IndexRange {
+    size_t begin;
+    size_t end;
+};
+
+// Chunk boundaries of [0, count): every boundary inside the range is offset + k * unit,
+// so when unit elements make a cache line and offset is where the first line starts,
+// no cache line is written by two threads.
+class ChunkGrid {
+private:
+    size_t _count;
+    size_t _unit;
+    size_t _offset;
+
+public:
+    ChunkGrid(size_t count, size_t unit, size_t offset)
+        : _count(count), _unit(std::max<size_t>(unit, 1)), _offset(std::min(offset, count)) {}
+
+    size_t count() const { return _count; }
+
+    // the first boundary at or after position
+    size_t boundary(size_t position) const {
+        if (position == 0 || position >= _count) return std::min(position, _count);
+        if (position <= _offset) return _offset;
+        size_t lines = (position - _offset + _unit - 1) / _unit;
+        return std::min(_offset + lines * _unit, _count);
+    }
+};
+
+// Calls body(begin, end) on disjoint chunks covering grid, on the pool's threads.
+// grain is the smallest chunk worth a thread (except for the last one).
+template <typename F>
+void parallelForChunks(const ChunkGrid& grid, size_t grain, F&& body, Schedule schedule, ThreadPool& pool) {
+    size_t count = grid.count();
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    unsigned threads = static_cast<unsigned>(std::min<size_t>(pool.concurrency(), (count + grain - 1) / grain));
+    if (threads <= 1) {
+        body(size_t(0), count);
+        return;
+    }
+
+    if (schedule == Schedule::Static) {
+        pool.run(threads, [&](unsigned index) {
+            size_t begin = grid.boundary(count * index / threads);
+            size_t end = grid.boundary(count * (index + 1) / threads);
+            if (begin < end) body(begin, end);
+        });
+        return;
+    }
+
+    // guided: half of an even share of what is left, at least grain
+    struct alignas(cacheLineSize) Cursor {
+        std::atomic<size_t> next{ 0 };
+    } cursor;
+    pool.run(threads, [&](unsigned) {
+        size_t begin = cursor.next.load(std::memory_order_relaxed);
+        while (begin < count) {
+            size_t size = std::max(grain, (count - begin) / (2 * size_t(threads)));
+            size_t end = grid.boundary(begin + size);
+            if (cursor.next.compare_exchange_weak(begin, end, std::memory_order_relaxed)) {
+                body(begin, end);
+                begin = cursor.next.load(std::memory_order_relaxed);
+            }
+        }
+    });
+}
+
+// body(begin, end) for chunks of an index range
+template <typename F>
+void parallel_for(IndexRange range, size_t grain, F&& body, Schedule schedule = Schedule::Static,
+                  ThreadPool& pool = ThreadPool::global()) {
+    if (range.end <= range.begin) return;
+    parallelForChunks(ChunkGrid(range.end - range.begin, 1, 0), grain,
+                      [&](size_t begin, size_t end) { body(range.begin + begin, range.begin + end); },
+                      schedule, pool);
+}
+
+// body(std::span<T>) for contiguous chunks of range, split on cache line boundaries.
+// The body gets plain spans, so a simple loop over one can be vectorized.
+template <typename T, typename F>
+void parallel_for(std::span<T> range, size_t grain, F&& body, Schedule schedule = Schedule::Static,
+                  ThreadPool& pool = ThreadPool::global()) {
+    size_t unit = 1;
+    size_t offset = 0;
+    auto address = reinterpret_cast<std::uintptr_t>(range.data());
+    if (cacheLineSize % sizeof(T) == 0 && address % sizeof(T) == 0) {
+        unit = cacheLineSize / sizeof(T);
+        offset = (cacheLineSize - address % cacheLineSize) % cacheLineSize / sizeof(T);
+    }
+    parallelForChunks(ChunkGrid(range.size(), unit, offset), std::max(grain, unit),
+                      [&](size_t begin, size_t end) { body(range.subspan(begin, end - begin)); },
+                      schedule, pool);
+}
+
+#endif // PARALLEL_FOR_H
@@ -0,0 +1,159 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// tells the CPU we are busy-waiting (frees the core for the sibling hyper-thread)
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/* fixed set of threads that are started once and reused by every parallel operation */
+class ThreadPool {
+public:
+    // concurrency: threads working on a run() including the calling one
+    explicit ThreadPool(unsigned concurrency = defaultConcurrency()) {
+        unsigned workerCount = std::max(concurrency, 1u) - 1;
+        _workers.reserve(workerCount);
+        for (unsigned i = 0; i < workerCount; ++i) {
+            _workers.emplace_back([this, i] { workerLoop(i + 1); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        std::uint64_t ticket = _ticket.load(std::memory_order_relaxed);
+        _ticket.store(((ticket >> 32) + 1) << 32 | stopCount, std::memory_order_release);
+        _ticket.notify_all();
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    static unsigned defaultConcurrency() {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // shared by the parallel algorithms that are not given a pool
+    static ThreadPool& global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    unsigned concurrency() const { return static_cast<unsigned>(_workers.size()) + 1; }
+
+    // Calls task(index) for every index in [0, count), index 0 on the calling thread and
+    // the others on workers, and returns when all have finished. count is capped at
+    // concurrency(). The first exception thrown by a task is rethrown here.
+    // Runs from different threads take turns; a run started from inside a task
+    // executes all indices on the calling thread.
+    template <typename F>
+    void run(unsigned count, F&& task) {
+        count = std::min(count, concurrency());
+        if (count <= 1 || insideTask()) {
+            for (unsigned index = 0; index < count; ++index) task(index);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_runMutex);
+        using Task = std::remove_reference_t<F>;
+        _task = const_cast<void*>(static_cast<const void*>(std::addressof(task)));
+        _invoke = [](void* task, unsigned index) { (*static_cast<Task*>(task))(index); };
+        _error = nullptr;
+        _pending.store(count - 1, std::memory_order_relaxed);
+
+        // new generation in the high half, participant count in the low half
+        std::uint64_t ticket = _ticket.load(std::memory_order_relaxed);
+        _ticket.store(((ticket >> 32) + 1) << 32 | count, std::memory_order_release);
+        _ticket.notify_all();
+
+        runTask(0);
+
+        for (int spin = 0; spin < spinCount && _pending.load(std::memory_order_acquire) != 0; ++spin) {
+            cpuRelax();
+        }
+        for (unsigned pending; (pending = _pending.load(std::memory_order_acquire)) != 0;) {
+            _pending.wait(pending, std::memory_order_acquire);
+        }
+
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+    }
+
+private:
+    static constexpr std::uint64_t stopCount = 0xffffffff;
+    static constexpr int spinCount = 256;  // some microseconds of polling before sleeping in the kernel
+
+    std::vector<std::thread> _workers;
+    std::mutex _runMutex;
+    void* _task = nullptr;
+    void (*_invoke)(void*, unsigned) = nullptr;
+    std::exception_ptr _error;
+    std::mutex _errorMutex;
+
+    // separate cache lines: workers poll _ticket while finishing ones decrement _pending
+    alignas(64) std::atomic<std::uint64_t> _ticket{ 0 };
+    alignas(64) std::atomic<unsigned> _pending{ 0 };
+
+    static bool& insideTask() {
+        thread_local bool inside = false;
+        return inside;
+    }
+
+    void runTask(unsigned index) {
+        insideTask() = true;
+        try {
+            _invoke(_task, index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(_errorMutex);
+            if (!_error) _error = std::current_exception();
+        }
+        insideTask() = false;
+    }
+
+    void workerLoop(unsigned index) {
+        std::uint64_t seen = 0;
+        for (;;) {
+            std::uint64_t ticket = _ticket.load(std::memory_order_acquire);
+            for (int spin = 0; spin < spinCount && ticket == seen; ++spin) {
+                cpuRelax();
+                ticket = _ticket.load(std::memory_order_acquire);
+            }
+            while (ticket == seen) {
+                _ticket.wait(seen, std::memory_order_acquire);
+                ticket = _ticket.load(std::memory_order_acquire);
+            }
+            seen = ticket;
+
+            std::uint64_t count = ticket & 0xffffffff;
+            if (count == stopCount) return;
+            if (index >= count) continue;  // not needed for this run
+
+            runTask(index);
+            if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                _pending.notify_one();
+            }
+        }
+    }
+};
+
+#endif // THREAD_POOL_H
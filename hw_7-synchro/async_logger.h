@@ -0,0 +1,464 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mpmc_queue.h"  // cacheLineSize, cpuRelax
+
+// What a log call does when its thread's buffer is full
+enum class LogOverflow {
+    Drop,   // discard the message; the flusher reports how many were lost
+    Block,  // wait until the flusher has made room
+};
+
+/* the flusher's output: text collected in a large buffer, written with one call when full */
+class LogOutput {
+private:
+    std::FILE* _file;
+    std::vector<char> _buffer;
+    size_t _used = 0;
+
+public:
+    LogOutput(std::FILE* file, size_t bytes) : _file(file), _buffer(bytes) {}
+
+    // room for size characters; write them and commit(size) them
+    char* reserve(size_t size) {
+        if (_buffer.size() - _used < size) {
+            flush();
+            if (_buffer.size() < size) _buffer.resize(size);
+        }
+        return _buffer.data() + _used;
+    }
+
+    void commit(size_t size) { _used += size; }
+
+    void append(std::string_view text) {
+        std::memcpy(reserve(text.size()), text.data(), text.size());
+        commit(text.size());
+    }
+
+    void flush() {
+        if (_used > 0) {
+            std::fwrite(_buffer.data(), 1, _used, _file);
+            std::fflush(_file);
+            _used = 0;
+        }
+    }
+};
+
+// How an argument of a log call is copied into a record (on the logging thread) and
+// printed from it (on the flusher): numbers as their bytes, strings as length + characters.
+template <typename T>
+struct LogArgument;
+
+template <typename T>
+    requires std::is_arithmetic_v<T> && (!std::is_same_v<T, bool>) && (!std::is_same_v<T, char>)
+struct LogArgument<T> {
+    static size_t size(T) { return sizeof(T); }
+
+    static void store(std::byte*& out, T value) {
+        std::memcpy(out, &value, sizeof(T));
+        out += sizeof(T);
+    }
+
+    static void print(const std::byte*& in, LogOutput& output) {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        char* text = output.reserve(64);
+        output.commit(static_cast<size_t>(std::to_chars(text, text + 64, value).ptr - text));
+    }
+};
+
+template <>
+struct LogArgument<char> {
+    static size_t size(char) { return 1; }
+    static void store(std::byte*& out, char value) { *out++ = static_cast<std::byte>(value); }
+    static void print(const std::byte*& in, LogOutput& output) {
+        char value = static_cast<char>(*in++);
+        output.append(std::string_view(&value, 1));
+    }
+};
+
+template <>
+struct LogArgument<bool> {
+    static size_t size(bool) { return 1; }
+    static void store(std::byte*& out, bool value) { *out++ = std::byte{ value }; }
+    static void print(const std::byte*& in, LogOutput& output) {
+        output.append(*in++ != std::byte{ 0 } ? "1" : "0");  // as operator<< prints it
+    }
+};
+
+template <typename T>
+    requires std::is_convertible_v<const T&, std::string_view>
+struct LogArgument<T> {
+    static size_t size(const T& value) { return sizeof(std::uint32_t) + std::string_view(value).size(); }
+
+    static void store(std::byte*& out, const T& value) {
+        std::string_view text(value);
+        auto length = static_cast<std::uint32_t>(text.size());
+        std::memcpy(out, &length, sizeof length);
+        std::memcpy(out + sizeof length, text.data(), text.size());
+        out += sizeof length + text.size();
+    }
+
+    static void print(const std::byte*& in, LogOutput& output) {
+        std::uint32_t length;
+        std::memcpy(&length, in, sizeof length);
+        output.append(std::string_view(reinterpret_cast<const char*>(in + sizeof length), length));
+        in += sizeof length + length;
+    }
+};
+
+/* single-producer single-consumer byte ring of one thread's records */
+class LogRing {
+public:
+    // every record starts with this header, at a multiple of recordAlignment
+    struct Header {
+        std::uint32_t size;  // bytes of the whole record
+        void (*print)(const std::byte* payload, LogOutput& output);  // nullptr: skip to the end of the ring
+    };
+    static constexpr size_t recordAlignment = 16;
+    static_assert(sizeof(Header) <= recordAlignment);
+
+private:
+    std::unique_ptr<std::byte[]> _data;
+    size_t _mask;
+
+    alignas(cacheLineSize) std::atomic<std::uint64_t> _write{ 0 };  // written by the owner thread
+    std::uint64_t _cachedRead = 0;      // owner's last look at _read: most calls do not touch the flusher's line
+    std::uint64_t _reserved = 0;        // position of the record being written
+
+    alignas(cacheLineSize) std::atomic<std::uint64_t> _read{ 0 };   // written by the flusher
+
+public:
+    std::atomic<std::uint64_t> dropped{ 0 };
+    std::atomic<bool> retired{ false };  // the owner thread has exited
+
+    explicit LogRing(size_t capacity)
+        : _data(new std::byte[capacity])
+        , _mask(capacity - 1)
+    {
+    }
+
+    size_t capacity() const { return _mask + 1; }
+
+    // Owner thread: space for a record of size bytes (a multiple of recordAlignment),
+    // or nullptr if the flusher has not freed enough yet. A record never wraps around:
+    // the rest of the ring is skipped with a padding header instead.
+    std::byte* tryReserve(size_t size) {
+        std::uint64_t pos = _write.load(std::memory_order_relaxed);
+        size_t offset = static_cast<size_t>(pos & _mask);
+        size_t contiguous = capacity() - offset;
+        size_t needed = size <= contiguous ? size : contiguous + size;
+        if (pos + needed - _cachedRead > capacity()) {
+            _cachedRead = _read.load(std::memory_order_acquire);
+            if (pos + needed - _cachedRead > capacity()) return nullptr;
+        }
+        if (size > contiguous) {
+            Header padding{ static_cast<std::uint32_t>(contiguous), nullptr };
+            std::memcpy(_data.get() + offset, &padding, sizeof padding);
+            pos += contiguous;
+            offset = 0;
+        }
+        _reserved = pos;
+        return _data.get() + offset;
+    }
+
+    // Owner thread: makes the reserved record visible to the flusher
+    void publish(size_t size) {
+        _write.store(_reserved + size, std::memory_order_release);
+    }
+
+    // Flusher: prints every published record; returns how many bytes were consumed
+    size_t drain(LogOutput& output) {
+        std::uint64_t read = _read.load(std::memory_order_relaxed);
+        std::uint64_t write = _write.load(std::memory_order_acquire);
+        std::uint64_t start = read;
+        while (read < write) {
+            const std::byte* record = _data.get() + (read & _mask);
+            Header header;
+            std::memcpy(&header, record, sizeof header);
+            if (header.print) header.print(record + recordAlignment, output);
+            read += header.size;
+        }
+        _read.store(read, std::memory_order_release);
+        return static_cast<size_t>(read - start);
+    }
+
+    bool empty() const {
+        return _read.load(std::memory_order_acquire) == _write.load(std::memory_order_acquire);
+    }
+};
+
+// Asynchronous logger: a log call formats nothing and takes no lock. It copies its
+// arguments into a record in the calling thread's own ring buffer; a background thread
+// turns the records of all threads into text and writes it in large blocks.
+//
+//     logger.log("Producer {} produced data: {}\n", id, data);  // {} placeholders, in order
+//     logger.write("preformatted text\n");
+//
+// The format must be a string literal (only its address is stored). Numbers, chars, bools
+// and strings are supported; strings are copied. Memory is bounded by the ring size per
+// logging thread; when a ring is full the call drops the message or waits, as chosen.
+// Messages of one thread appear in order; messages of different threads are interleaved
+// by whole messages.
+class AsyncLogger {
+public:
+    explicit AsyncLogger(std::FILE* file = stdout, LogOverflow overflow = LogOverflow::Block,
+                         size_t threadBufferBytes = size_t(64) << 10,
+                         std::chrono::milliseconds flushInterval = std::chrono::milliseconds(2))
+        : _file(file)
+        , _overflow(overflow)
+        , _ringBytes(std::bit_ceil(std::max(threadBufferBytes, size_t(4096))))
+        , _flushInterval(flushInterval)
+        , _id(nextId())
+    {
+        _flusher = std::thread([this] { flusherLoop(); });
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // writes everything logged so far
+    ~AsyncLogger() {
+        {
+            std::lock_guard<std::mutex> lock(_wakeMutex);
+            _stopping = true;
+        }
+        _wake.notify_one();
+        _flusher.join();
+    }
+
+    template <size_t N, typename... Args>
+    void log(const char (&format)[N], const Args&... args) {
+        const char* formatPointer = format;
+        size_t size = LogRing::recordAlignment + sizeof formatPointer + (LogArgument<std::decay_t<Args>>::size(args) + ... + 0);
+        size = (size + LogRing::recordAlignment - 1) & ~(LogRing::recordAlignment - 1);
+
+        LogRing& ring = localRing();
+        std::byte* record = reserve(ring, size);
+        if (!record) return;
+
+        LogRing::Header header{ static_cast<std::uint32_t>(size), &printRecord<std::decay_t<Args>...> };
+        std::memcpy(record, &header, sizeof header);
+        std::byte* out = record + LogRing::recordAlignment;
+        std::memcpy(out, &formatPointer, sizeof formatPointer);
+        out += sizeof formatPointer;
+        (LogArgument<std::decay_t<Args>>::store(out, args), ...);
+        ring.publish(size);
+    }
+
+    // preformatted text, copied as is
+    void write(std::string_view text) {
+        size_t size = LogRing::recordAlignment + LogArgument<std::string_view>::size(text);
+        size = (size + LogRing::recordAlignment - 1) & ~(LogRing::recordAlignment - 1);
+
+        LogRing& ring = localRing();
+        std::byte* record = reserve(ring, size);
+        if (!record) return;
+
+        LogRing::Header header{ static_cast<std::uint32_t>(size), &printText };
+        std::memcpy(record, &header, sizeof header);
+        std::byte* out = record + LogRing::recordAlignment;
+        LogArgument<std::string_view>::store(out, text);
+        ring.publish(size);
+    }
+
+    // returns once everything logged before the call has been written out
+    void flush() {
+        std::uint64_t ticket;
+        {
+            std::lock_guard<std::mutex> lock(_wakeMutex);
+            ticket = ++_flushRequests;
+        }
+        _wake.notify_one();
+        for (std::uint64_t done; (done = _flushed.load(std::memory_order_acquire)) < ticket;) {
+            _flushed.wait(done, std::memory_order_acquire);
+        }
+    }
+
+    // messages discarded so far because a ring was full (LogOverflow::Drop)
+    std::uint64_t droppedCount() const { return _droppedTotal.load(std::memory_order_relaxed); }
+
+private:
+    std::FILE* _file;
+    LogOverflow _overflow;
+    size_t _ringBytes;
+    std::chrono::milliseconds _flushInterval;
+    std::uint64_t _id;  // never reused, unlike addresses: tells the per-thread caches apart
+
+    std::mutex _ringsMutex;  // taken by a thread's first log call and by the flusher
+    std::vector<std::shared_ptr<LogRing>> _rings;
+    std::atomic<std::uint64_t> _ringsVersion{ 0 };
+
+    std::mutex _wakeMutex;
+    std::condition_variable _wake;
+    bool _stopping = false;             // guarded by _wakeMutex
+    bool _roomWanted = false;           // guarded by _wakeMutex: a blocked log call waits for the flusher
+    std::uint64_t _flushRequests = 0;   // guarded by _wakeMutex
+    std::atomic<std::uint64_t> _flushed{ 0 };
+    std::atomic<std::uint64_t> _droppedTotal{ 0 };
+    std::thread _flusher;
+
+    static std::uint64_t nextId() {
+        static std::atomic<std::uint64_t> counter{ 0 };
+        return ++counter;
+    }
+
+    template <typename... Args>
+    static void printRecord(const std::byte* payload, LogOutput& output) {
+        const char* format;
+        std::memcpy(&format, payload, sizeof format);
+        payload += sizeof format;
+        std::string_view rest(format);
+        auto printArgument = [&]<typename A>(std::type_identity<A>) {
+            size_t placeholder = rest.find("{}");
+            output.append(rest.substr(0, placeholder));
+            rest = placeholder == std::string_view::npos ? std::string_view() : rest.substr(placeholder + 2);
+            LogArgument<A>::print(payload, output);
+        };
+        (printArgument(std::type_identity<Args>{}), ...);
+        output.append(rest);
+    }
+
+    static void printText(const std::byte* payload, LogOutput& output) {
+        LogArgument<std::string_view>::print(payload, output);
+    }
+
+    // the calling thread's ring for this logger, created and registered on first use
+    LogRing& localRing() {
+        struct ThreadRings {
+            std::uint64_t lastId = 0;
+            LogRing* last = nullptr;
+            std::vector<std::pair<std::uint64_t, std::shared_ptr<LogRing>>> rings;
+
+            ~ThreadRings() {
+                for (auto& entry : rings) entry.second->retired.store(true, std::memory_order_release);
+            }
+        };
+        thread_local ThreadRings local;
+        if (local.lastId == _id) return *local.last;
+
+        LogRing* found = nullptr;
+        for (auto& entry : local.rings) {
+            if (entry.first == _id) found = entry.second.get();
+        }
+        if (!found) {
+            auto ring = std::make_shared<LogRing>(_ringBytes);
+            {
+                std::lock_guard<std::mutex> lock(_ringsMutex);
+                _rings.push_back(ring);
+                _ringsVersion.fetch_add(1, std::memory_order_release);
+            }
+            found = ring.get();
+            local.rings.emplace_back(_id, std::move(ring));
+        }
+        local.lastId = _id;
+        local.last = found;
+        return *found;
+    }
+
+    std::byte* reserve(LogRing& ring, size_t size) {
+        if (size > ring.capacity() / 2) {  // could not be guaranteed to ever fit
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (std::byte* record = ring.tryReserve(size)) return record;
+        if (_overflow == LogOverflow::Drop) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_wakeMutex);  // do not wait for the flush interval
+            _roomWanted = true;
+        }
+        _wake.notify_one();
+        for (int attempt = 0;; ++attempt) {
+            if (std::byte* record = ring.tryReserve(size)) return record;
+            if (attempt < 64) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void flusherLoop() {
+        LogOutput output(_file, size_t(256) << 10);
+        std::vector<std::shared_ptr<LogRing>> rings;
+        std::uint64_t ringsVersion = ~std::uint64_t(0);
+
+        for (;;) {
+            bool stopping;
+            std::uint64_t flushTicket;
+            {
+                std::lock_guard<std::mutex> lock(_wakeMutex);
+                stopping = _stopping;
+                flushTicket = _flushRequests;
+                _roomWanted = false;
+            }
+
+            if (_ringsVersion.load(std::memory_order_acquire) != ringsVersion) {
+                std::lock_guard<std::mutex> lock(_ringsMutex);
+                rings = _rings;
+                ringsVersion = _ringsVersion.load(std::memory_order_relaxed);
+            }
+
+            size_t drained = 0;
+            bool anyRetired = false;
+            for (auto& ring : rings) {
+                drained += ring->drain(output);
+                if (std::uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed)) {
+                    _droppedTotal.fetch_add(dropped, std::memory_order_relaxed);
+                    char text[80];
+                    int length = std::snprintf(text, sizeof text, "[async logger: %llu messages dropped]\n",
+                                               static_cast<unsigned long long>(dropped));
+                    output.append(std::string_view(text, static_cast<size_t>(length)));
+                }
+                anyRetired = anyRetired || ring->retired.load(std::memory_order_acquire);
+            }
+            output.flush();
+
+            if (_flushed.load(std::memory_order_relaxed) != flushTicket) {
+                _flushed.store(flushTicket, std::memory_order_release);
+                _flushed.notify_all();
+            }
+            if (stopping) return;
+
+            if (anyRetired) {
+                // rings of exited threads go once they are empty
+                std::lock_guard<std::mutex> lock(_ringsMutex);
+                size_t removed = std::erase_if(_rings, [](const std::shared_ptr<LogRing>& ring) {
+                    return ring->retired.load(std::memory_order_acquire) && ring->empty();
+                });
+                if (removed > 0) _ringsVersion.fetch_add(1, std::memory_order_release);
+            }
+
+            if (drained == 0) {
+                std::unique_lock<std::mutex> lock(_wakeMutex);
+                _wake.wait_for(lock, _flushInterval, [&] {
+                    return _stopping || _roomWanted || _flushRequests != flushTicket;
+                });
+            }
+        }
+    }
+};
+
+#endif // ASYNC_LOGGER_H
@@ -6,6 +6,16 @@
 #include <vector>
 #include <atomic>
 #include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <span>
+#include <string>
+
+#include "async_logger.h"
+#include "mpmc_queue.h"
 
 // Key Points in Implementation:
 // 
@@ -22,6 +32,8 @@
 // Synchronization:
 // - A std::mutex ensures safe access to the shared buffer.
 // - A std::condition_variable coordinates producers and consumers, avoiding busy waiting.
+// - Messages go to an AsyncLogger after the mutex is released: a log call only copies
+//   its arguments into a per-thread buffer, a background thread formats and writes them.
 // 
 // Practicality:
 // - The system simulates real-world scenarios like logging systems or task queues,
@@ -43,6 +55,7 @@ std::condition_variable cv;             // Condition variable for synchronizatio
 std::atomic<int> produced{ 0 };   // Total number of produced items
 std::atomic<int> consumed{ 0 };   // Total number of consumed items
 bool productionComplete = false;        // Flag indicating production is complete
+AsyncLogger logger;                     // Progress messages, written to stdout in the background
 
 // Producer function
 void producer(int id) {
@@ -59,13 +72,13 @@ void producer(int id) {
             // Lock the buffer and add data
             std::lock_guard<std::mutex> lock(bufferMutex);
             buffer.push(data);
-            std::cout << ("Producer " + std::to_string(id) + " produced data: " + std::to_string(data) + "\n");
         }
 
         cv.notify_one();  // Notify a consumer that data is available
+        logger.log("Producer {} produced data: {}\n", id, data);
     }
 
-    std::cout << ("Producer " + std::to_string(id) + " finished work.\n");
+    logger.log("Producer {} finished work.\n", id);
 }
 
 // Consumer function
@@ -84,17 +97,238 @@ void consumer(int id) {
             data = buffer.front();
             buffer.pop();
             consumed++;
-            std::cout << ("Consumer " + std::to_string(id) + " consumed data: " + std::to_string(data) + "\n");
         }
+        logger.log("Consumer {} consumed data: {}\n", id, data);
 
         // Simulate data processing
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
-    std::cout << ("Consumer " + std::to_string(id) + " finished work.\n");
+    logger.log("Consumer {} finished work.\n", id);
+}
+
+// The design above as a class: the benchmark baseline
+template <typename T>
+class LockedQueue {
+private:
+    std::queue<T> items;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool closed = false;
+
+public:
+    void push(T value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push(std::move(value));
+        }
+        cv.notify_one();
+    }
+
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return !items.empty() || closed; });
+        if (items.empty()) {
+            return false;
+        }
+        out = std::move(items.front());
+        items.pop();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        cv.notify_all();
+    }
+};
+
+struct BenchmarkConfig {
+    int producers = 4;
+    int consumers = 4;
+    std::int64_t items = 2'000'000;
+    size_t batch = 32;
+};
+
+using Timestamp = std::int64_t;  // steady_clock nanoseconds when the item was produced
+
+Timestamp now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Runs the producers and consumers over queue without any simulated work and reports
+// throughput and the time items spent between push and pop. batch > 1 uses pushBatch/popBatch.
+template <typename Queue>
+void runPipeline(const std::string& name, Queue& queue, const BenchmarkConfig& config, size_t batch) {
+    std::vector<std::vector<Timestamp>> latencies(config.consumers);
+    std::vector<std::thread> threads;
+
+    Timestamp start = now();
+    for (int p = 0; p < config.producers; ++p) {
+        std::int64_t count = config.items / config.producers + (p < config.items % config.producers ? 1 : 0);
+        threads.emplace_back([&queue, count, batch] {
+            if constexpr (requires(std::span<Timestamp> items) { queue.pushBatch(items); }) {
+                if (batch > 1) {
+                    std::vector<Timestamp> items(batch);
+                    for (std::int64_t done = 0; done < count;) {
+                        size_t size = static_cast<size_t>(std::min<std::int64_t>(batch, count - done));
+                        for (size_t i = 0; i < size; ++i) items[i] = now();
+                        queue.pushBatch(std::span<Timestamp>(items.data(), size));
+                        done += size;
+                    }
+                    return;
+                }
+            }
+            for (std::int64_t i = 0; i < count; ++i) {
+                queue.push(now());
+            }
+        });
+    }
+    for (int c = 0; c < config.consumers; ++c) {
+        latencies[c].reserve(static_cast<size_t>(config.items / config.consumers * 2));
+        threads.emplace_back([&queue, &samples = latencies[c], batch] {
+            if constexpr (requires(std::span<Timestamp> items) { queue.popBatch(items); }) {
+                if (batch > 1) {
+                    std::vector<Timestamp> items(batch);
+                    while (size_t count = queue.popBatch(items)) {
+                        Timestamp received = now();
+                        for (size_t i = 0; i < count; ++i) samples.push_back(received - items[i]);
+                    }
+                    return;
+                }
+            }
+            Timestamp item;
+            while (queue.pop(item)) {
+                samples.push_back(now() - item);
+            }
+        });
+    }
+    for (int p = 0; p < config.producers; ++p) {
+        threads[p].join();
+    }
+    queue.close();
+    for (size_t t = config.producers; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    double seconds = (now() - start) / 1e9;
+
+    std::vector<Timestamp> all;
+    for (const auto& samples : latencies) all.insert(all.end(), samples.begin(), samples.end());
+    auto percentile = [&all](double fraction) {
+        auto nth = all.begin() + static_cast<std::ptrdiff_t>(fraction * (all.size() - 1));
+        std::nth_element(all.begin(), nth, all.end());
+        return *nth / 1000.0;
+    };
+    std::cout << "  " << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << all.size() / seconds / 1e6 << " M/s"
+              << std::setw(10) << percentile(0.5) << std::setw(10) << percentile(0.9)
+              << std::setw(10) << percentile(0.99) << std::setw(10) << percentile(0.999)
+              << std::setw(12) << percentile(1.0)
+              << (static_cast<std::int64_t>(all.size()) == config.items ? "" : "  LOST ITEMS") << "\n";
+}
+
+// hw7 bench [producers] [consumers] [items] [batch]
+void runBenchmarks(const BenchmarkConfig& config) {
+    std::cout << "Pipeline: " << config.producers << " producers, " << config.consumers << " consumers, "
+              << config.items << " items, no simulated work\n";
+    std::cout << "  " << std::left << std::setw(30) << "queue" << std::right << std::setw(14) << "throughput"
+              << "   latency us: p50       p90       p99     p99.9         max\n";
+
+    LockedQueue<Timestamp> locked;
+    runPipeline("mutex + condition_variable", locked, config, 1);
+
+    MpmcQueue<Timestamp> ring(4096);
+    runPipeline("MpmcQueue", ring, config, 1);
+
+    if (config.batch > 1) {
+        MpmcQueue<Timestamp> batched(4096);
+        runPipeline("MpmcQueue, batches of " + std::to_string(config.batch), batched, config, config.batch);
+    }
+}
+
+#ifdef _WIN32
+constexpr const char* nullDevice = "NUL";
+#else
+constexpr const char* nullDevice = "/dev/null";
+#endif
+
+// Nanoseconds of a core per log call, with threads logging messages each at the same time
+template <typename F>
+double timeLogCalls(int threads, int messages, F logCall) {
+    std::vector<std::thread> workers;
+    Timestamp start = now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t, messages, &logCall] {
+            for (int i = 0; i < messages; ++i) logCall(t, i);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    unsigned cores = std::min<unsigned>(threads, std::max(std::thread::hardware_concurrency(), 1u));
+    return double(now() - start) * cores / (double(threads) * messages);
+}
+
+// hw7 bench-log [threads] [messages]: cost of one progress message on the calling thread
+void runLoggerBenchmarks(int threads, int messages) {
+    std::cout << "Logging: " << threads << " threads, " << messages << " messages each, to " << nullDevice << "\n";
+    auto report = [](const std::string& name, double nanoseconds, const std::string& note = "") {
+        std::cout << "  " << std::left << std::setw(52) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(9) << nanoseconds << " ns/call" << note << "\n";
+    };
+
+    {
+        // the original: concatenate a std::string and write it to a stream under the queue mutex
+        std::ofstream out(nullDevice);
+        std::mutex mutex;
+        report("string concatenation + ostream under mutex", timeLogCalls(threads, messages, [&](int id, int data) {
+            std::lock_guard<std::mutex> lock(mutex);
+            out << ("Producer " + std::to_string(id) + " produced data: " + std::to_string(data) + "\n");
+        }));
+    }
+
+    for (LogOverflow overflow : { LogOverflow::Block, LogOverflow::Drop }) {
+        std::string policy = overflow == LogOverflow::Block ? "block" : "drop";
+        std::FILE* file = std::fopen(nullDevice, "w");
+        double deferred, preformatted;
+        std::uint64_t dropped;
+        {
+            AsyncLogger nullLogger(file, overflow);
+            deferred = timeLogCalls(threads, messages, [&](int id, int data) {
+                nullLogger.log("Producer {} produced data: {}\n", id, data);
+            });
+            preformatted = timeLogCalls(threads, messages, [&](int, int) {
+                nullLogger.write("Producer finished work.\n");
+            });
+            nullLogger.flush();
+            dropped = nullLogger.droppedCount();
+        }
+        std::fclose(file);
+        std::string note = overflow == LogOverflow::Drop ? "   (" + std::to_string(dropped) + " dropped)" : "";
+        report("AsyncLogger::log, " + policy + " when full", deferred, note);
+        report("AsyncLogger::write (preformatted), " + policy + " when full", preformatted);
+    }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "bench-log") {
+        int threads = argc > 2 ? std::max(1, std::stoi(argv[2])) : 4;
+        int messages = argc > 3 ? std::max(1, std::stoi(argv[3])) : 1'000'000;
+        runLoggerBenchmarks(threads, messages);
+        return 0;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        BenchmarkConfig config;
+        if (argc > 2) config.producers = std::max(1, std::stoi(argv[2]));
+        if (argc > 3) config.consumers = std::max(1, std::stoi(argv[3]));
+        if (argc > 4) config.items = std::max<std::int64_t>(1, std::stoll(argv[4]));
+        if (argc > 5) config.batch = std::max<size_t>(1, std::stoul(argv[5]));
+        runBenchmarks(config);
+        return 0;
+    }
+
     std::vector<std::thread> producers;
     std::vector<std::thread> consumers;
 
@@ -125,6 +359,7 @@ int main() {
         consumerThread.join();
     }
 
+    logger.flush();  // the summary comes after all progress messages
     std::cout << "All data produced: " << produced.load() << ", All data consumed: " << consumed.load() << std::endl;
 
     return 0;
@@ -0,0 +1,305 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+constexpr size_t cacheLineSize = 64;
+
+// tells the CPU we are busy-waiting (frees the core for the sibling hyper-thread)
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Waiting for a condition another thread makes true: spin for a moment (cheap when the
+// wait is short), then yield, then sleep in the kernel until notify(). notify() costs a
+// fence and a load while nobody sleeps, so it can be called after every change; the first
+// notify() after threads went to sleep takes them all off the list and wakes them with one
+// system call, the ones that still cannot proceed register again.
+class SpinThenPark {
+private:
+    static constexpr int spinCount = 128;
+    static constexpr int yieldCount = 16;
+
+    alignas(cacheLineSize) std::atomic<std::uint32_t> _epoch{ 0 };
+    std::atomic<std::uint32_t> _sleepers{ 0 };
+
+public:
+    // returns once ready() has returned true
+    template <typename Ready>
+    void waitUntil(Ready ready) {
+        // on a single hardware thread the other side cannot run while we spin
+        static const int spins = std::thread::hardware_concurrency() > 1 ? spinCount : 0;
+        for (int i = 0; i < spins; ++i) {
+            if (ready()) return;
+            cpuRelax();
+        }
+        for (int i = 0; i < yieldCount; ++i) {
+            if (ready()) return;
+            std::this_thread::yield();
+        }
+        for (;;) {
+            std::uint32_t epoch = _epoch.load(std::memory_order_acquire);
+            _sleepers.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);  // pairs with the fence in notify()
+            // A waiter that does not sleep after all stays registered: the count may already
+            // belong to waiters that registered after a notify() cleared it, and taking one
+            // of theirs would let them sleep unseen. The cost is one needless wake-up call.
+            if (ready()) return;
+            _epoch.wait(epoch, std::memory_order_acquire);
+            if (ready()) return;
+        }
+    }
+
+    // wakes the sleeping waiters after a change that may make their condition true
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_sleepers.load(std::memory_order_relaxed) != 0 &&
+            _sleepers.exchange(0, std::memory_order_relaxed) != 0) {
+            _epoch.fetch_add(1, std::memory_order_release);
+            _epoch.notify_all();
+        }
+    }
+};
+
+// Bounded lock-free multi-producer multi-consumer queue (ring buffer with a sequence
+// number per slot). A slot at position p is free for the producer of p when its sequence
+// is p and holds that producer's item when it is p + 1; the consumer then sets it to
+// p + capacity for the next lap. Producers and consumers only contend on their own
+// index, each on its own cache line, and nothing is allocated after construction.
+template <typename T>
+class MpmcQueue {
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    struct alignas(cacheLineSize) Index {
+        std::atomic<size_t> value{ 0 };
+    };
+
+    size_t _mask;
+    std::unique_ptr<Slot[]> _slots;
+    Index _tail;  // next position to push
+    Index _head;  // next position to pop
+    SpinThenPark _notEmpty;
+    SpinThenPark _notFull;
+    alignas(cacheLineSize) std::atomic<bool> _closed{ false };
+
+    static std::ptrdiff_t distance(size_t from, size_t to) {
+        return static_cast<std::ptrdiff_t>(to - from);
+    }
+
+    // Producers waiting on a full queue are woken only once a quarter of it is free, so a
+    // woken producer can push a run of items instead of one per wake-up. Consumers drain
+    // the queue before they sleep, so it always gets there.
+    bool roomForProducers() const {
+        return sizeApprox() <= capacity() - capacity() / 4;
+    }
+
+public:
+    // capacity is rounded up to a power of two
+    explicit MpmcQueue(size_t capacity)
+        : _mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+        , _slots(new Slot[_mask + 1])
+    {
+        for (size_t i = 0; i <= _mask; ++i) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    ~MpmcQueue() {
+        for (size_t pos = _head.value.load(std::memory_order_relaxed);; ++pos) {
+            Slot& slot = _slots[pos & _mask];
+            if (slot.sequence.load(std::memory_order_relaxed) != pos + 1) break;
+            slot.item()->~T();
+        }
+    }
+
+    size_t capacity() const { return _mask + 1; }
+
+    // a snapshot: other threads may push and pop at the same time
+    size_t sizeApprox() const {
+        size_t head = _head.value.load(std::memory_order_relaxed);
+        size_t tail = _tail.value.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    // false if the queue is full; value is moved from only on success
+    template <typename U>
+    bool tryPush(U&& value) {
+        size_t pos = _tail.value.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = _slots[pos & _mask];
+            std::ptrdiff_t lag = distance(pos, slot.sequence.load(std::memory_order_acquire));
+            if (lag == 0) {
+                if (_tail.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    ::new (static_cast<void*>(slot.storage)) T(std::forward<U>(value));
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;  // the slot still holds the item from the previous lap
+            } else {
+                pos = _tail.value.load(std::memory_order_relaxed);  // another producer took pos
+            }
+        }
+    }
+
+    // false if the queue is empty
+    bool tryPop(T& out) {
+        size_t pos = _head.value.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = _slots[pos & _mask];
+            std::ptrdiff_t lag = distance(pos + 1, slot.sequence.load(std::memory_order_acquire));
+            if (lag == 0) {
+                if (_head.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(*slot.item());
+                    slot.item()->~T();
+                    slot.sequence.store(pos + capacity(), std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                pos = _head.value.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Pushes a prefix of items with one index update: the free slots from the tail are
+    // checked first and then claimed together. Returns how many were pushed (moved from).
+    size_t tryPushBatch(std::span<T> items) {
+        size_t limit = std::min(items.size(), capacity());
+        size_t pos = _tail.value.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t count = 0;
+            while (count < limit &&
+                   _slots[(pos + count) & _mask].sequence.load(std::memory_order_acquire) == pos + count) {
+                ++count;
+            }
+            if (count == 0) {
+                if (limit == 0 || distance(pos, _slots[pos & _mask].sequence.load(std::memory_order_acquire)) < 0) {
+                    return 0;
+                }
+                pos = _tail.value.load(std::memory_order_relaxed);
+                continue;
+            }
+            // only the producer owning a position changes its slot, so the checked slots stay free
+            if (_tail.value.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                for (size_t i = 0; i < count; ++i) {
+                    Slot& slot = _slots[(pos + i) & _mask];
+                    ::new (static_cast<void*>(slot.storage)) T(std::move(items[i]));
+                    slot.sequence.store(pos + i + 1, std::memory_order_release);
+                }
+                return count;
+            }
+        }
+    }
+
+    // Pops up to out.size() items with one index update; returns how many.
+    size_t tryPopBatch(std::span<T> out) {
+        size_t limit = std::min(out.size(), capacity());
+        size_t pos = _head.value.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t count = 0;
+            while (count < limit &&
+                   _slots[(pos + count) & _mask].sequence.load(std::memory_order_acquire) == pos + count + 1) {
+                ++count;
+            }
+            if (count == 0) {
+                if (limit == 0 || distance(pos + 1, _slots[pos & _mask].sequence.load(std::memory_order_acquire)) < 0) {
+                    return 0;
+                }
+                pos = _head.value.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (_head.value.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                for (size_t i = 0; i < count; ++i) {
+                    Slot& slot = _slots[(pos + i) & _mask];
+                    out[i] = std::move(*slot.item());
+                    slot.item()->~T();
+                    slot.sequence.store(pos + i + capacity(), std::memory_order_release);
+                }
+                return count;
+            }
+        }
+    }
+
+    // Blocking operations: wait with SpinThenPark while the queue is full or empty.
+
+    template <typename U>
+    void push(U&& value) {
+        if (!tryPush(std::forward<U>(value))) {
+            _notFull.waitUntil([&] { return tryPush(std::forward<U>(value)); });
+        }
+        _notEmpty.notify();
+    }
+
+    // all of items, in order (other producers' items may be interleaved)
+    void pushBatch(std::span<T> items) {
+        while (!items.empty()) {
+            size_t pushed = tryPushBatch(items);
+            if (pushed == 0) {
+                _notFull.waitUntil([&] { return (pushed = tryPushBatch(items)) != 0; });
+            }
+            items = items.subspan(pushed);
+            _notEmpty.notify();
+        }
+    }
+
+    // false once the queue is closed and empty
+    bool pop(T& out) {
+        bool popped = tryPop(out);
+        if (!popped) {
+            _notEmpty.waitUntil([&] { return (popped = tryPop(out)) || _closed.load(std::memory_order_acquire); });
+            if (!popped) popped = tryPop(out);  // pushed just before close()
+        }
+        if (popped && roomForProducers()) _notFull.notify();
+        return popped;
+    }
+
+    // waits for at least one item; 0 once the queue is closed and empty
+    size_t popBatch(std::span<T> out) {
+        size_t popped = tryPopBatch(out);
+        if (popped == 0) {
+            _notEmpty.waitUntil([&] {
+                return (popped = tryPopBatch(out)) != 0 || _closed.load(std::memory_order_acquire);
+            });
+            if (popped == 0) popped = tryPopBatch(out);
+        }
+        if (popped != 0 && roomForProducers()) _notFull.notify();
+        return popped;
+    }
+
+    // no more pushes: waiting consumers drain the queue and then get false / 0
+    void close() {
+        _closed.store(true, std::memory_order_release);
+        _notEmpty.notify();
+    }
+};
+
+#endif // MPMC_QUEUE_H
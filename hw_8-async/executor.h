@@ -0,0 +1,819 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+#include "thread_pool.h"  // cacheLineSize
+
+// tells the CPU we are busy-waiting (frees the core for the sibling hyper-thread)
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+template <typename T>
+class Future;
+
+namespace executor_detail {
+
+// a unit of work in an executor queue; run() executes it and disposes of it
+struct Task {
+    virtual void run() = 0;
+
+protected:
+    ~Task() = default;
+};
+
+// told once the result of a future has been set
+struct Continuation {
+    virtual void onReady() = 0;
+
+protected:
+    ~Continuation() = default;
+};
+
+// Chase-Lev work-stealing deque. The owner thread pushes and pops at the bottom (newest
+// first, while its data is still in cache); other threads steal from the top (oldest
+// first, usually the largest pieces of work). Only the last item is contended.
+class WorkDeque {
+private:
+    struct Ring {
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<Task*>[]> slots;
+
+        explicit Ring(std::int64_t capacity) : mask(capacity - 1), slots(new std::atomic<Task*>[capacity]) {}
+
+        Task* get(std::int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, Task* task) { slots[i & mask].store(task, std::memory_order_relaxed); }
+    };
+
+    alignas(cacheLineSize) std::atomic<std::int64_t> _top{ 0 };     // next to steal
+    alignas(cacheLineSize) std::atomic<std::int64_t> _bottom{ 0 };  // next to push
+    std::atomic<Ring*> _ring;
+    std::vector<std::unique_ptr<Ring>> _rings;  // thieves may still read a ring after it was replaced
+
+    Ring* grow(Ring* ring, std::int64_t top, std::int64_t bottom) {
+        auto bigger = std::make_unique<Ring>(2 * (ring->mask + 1));
+        for (std::int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, ring->get(i));
+        }
+        ring = bigger.get();
+        _rings.push_back(std::move(bigger));
+        _ring.store(ring, std::memory_order_release);
+        return ring;
+    }
+
+public:
+    WorkDeque() {
+        _rings.push_back(std::make_unique<Ring>(256));
+        _ring.store(_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(Task* task) {
+        std::int64_t bottom = _bottom.load(std::memory_order_relaxed);
+        std::int64_t top = _top.load(std::memory_order_acquire);
+        Ring* ring = _ring.load(std::memory_order_relaxed);
+        if (bottom - top > ring->mask) {
+            ring = grow(ring, top, bottom);
+        }
+        ring->put(bottom, task);
+        _bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // owner only; nullptr if empty
+    Task* pop() {
+        std::int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        Ring* ring = _ring.load(std::memory_order_relaxed);
+        _bottom.store(bottom, std::memory_order_seq_cst);  // must be visible before top is read
+        std::int64_t top = _top.load(std::memory_order_seq_cst);
+        if (top > bottom) {
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Task* task = ring->get(bottom);
+        if (top == bottom) {
+            // the last item: a thief may be taking it at the same time
+            if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                task = nullptr;
+            }
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    // any thread; nullptr if empty or another thread took the item first
+    Task* steal() {
+        std::int64_t top = _top.load(std::memory_order_seq_cst);
+        std::int64_t bottom = _bottom.load(std::memory_order_seq_cst);
+        if (top >= bottom) return nullptr;
+        Task* task = _ring.load(std::memory_order_acquire)->get(top);
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+
+    bool emptyApprox() const {
+        return _bottom.load(std::memory_order_relaxed) <= _top.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace executor_detail
+
+// Fixed set of worker threads running short tasks. Every worker has its own deque: tasks
+// spawned by a task go to the deque of its worker, tasks spawned by other threads to a
+// shared queue, and a worker that runs out of work steals from the others. Idle workers
+// spin briefly and then sleep until new work is pushed.
+class Executor {
+public:
+    using Task = executor_detail::Task;
+
+    explicit Executor(unsigned threads = defaultConcurrency()) {
+        unsigned count = std::max(threads, 1u);
+        for (unsigned i = 0; i < count; ++i) {
+            _workers.push_back(std::make_unique<Worker>());
+        }
+        for (unsigned i = 0; i < count; ++i) {
+            _workers[i]->thread = std::thread([this, i] { workerLoop(i); });
+        }
+    }
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    // runs the tasks that are still queued (and those they spawn), then stops the workers
+    ~Executor() {
+        _stop.store(true, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _epoch.fetch_add(1, std::memory_order_release);
+        _epoch.notify_all();
+        for (auto& worker : _workers) {
+            worker->thread.join();
+        }
+    }
+
+    static unsigned defaultConcurrency() {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // shared by everything that is not given an executor
+    static Executor& global() {
+        static Executor executor;
+        return executor;
+    }
+
+    // the executor whose worker is the calling thread, or nullptr
+    static Executor* ofThisThread() { return context().executor; }
+
+    // the executor of the calling worker, or global() on other threads
+    static Executor& current() {
+        Executor* executor = ofThisThread();
+        return executor ? *executor : global();
+    }
+
+    unsigned concurrency() const { return static_cast<unsigned>(_workers.size()); }
+
+    // Runs f() on a worker; the future gets its result or exception.
+    template <typename F>
+    auto spawn(F&& f);
+
+    // co_await executor.schedule() continues the coroutine on a worker
+    auto schedule() {
+        struct Awaiter final : Task {
+            Executor* executor;
+            std::coroutine_handle<> handle;
+
+            explicit Awaiter(Executor* executor) : executor(executor) {}
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                executor->push(this);
+            }
+            void await_resume() const noexcept {}
+            void run() override { handle.resume(); }
+        };
+        return Awaiter(this);
+    }
+
+    // Queues a task: on the calling worker's deque, or on the shared queue from other threads.
+    void push(Task* task) {
+        WorkerContext& self = context();
+        if (self.executor == this) {
+            _workers[self.index]->deque.push(task);
+        } else {
+            std::lock_guard<std::mutex> lock(_injectedMutex);
+            _injected.push_back(task);
+            _injectedCount.store(_injected.size(), std::memory_order_relaxed);
+        }
+        wakeSleepers();
+    }
+
+    // Called by a thread waiting for a future: runs one queued task, false if there was none.
+    // A worker of this executor looks in its own deque, the shared queue and the other
+    // workers' deques; any other thread has no deque and only takes from the shared queue.
+    bool runOne() {
+        Task* task = context().executor == this ? findWork(context().index) : takeInjectedTask();
+        if (task) {
+            task->run();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    static constexpr int spinCount = 64;  // rounds of polling the queues before sleeping
+    static constexpr int yieldCount = 8;
+    static constexpr size_t maxInjectedBatch = 32;
+
+    struct alignas(cacheLineSize) Worker {
+        executor_detail::WorkDeque deque;
+        std::uint32_t random = 0;  // picks the first victim to steal from
+        std::thread thread;
+    };
+
+    struct WorkerContext {
+        Executor* executor = nullptr;
+        unsigned index = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::mutex _injectedMutex;
+    std::deque<Task*> _injected;
+    std::atomic<size_t> _injectedCount{ 0 };
+    alignas(cacheLineSize) std::atomic<std::uint32_t> _epoch{ 0 };
+    std::atomic<std::uint32_t> _sleepers{ 0 };
+    std::atomic<bool> _stop{ false };
+
+    static WorkerContext& context() {
+        thread_local WorkerContext self;
+        return self;
+    }
+
+    // After new work was queued: wakes the sleeping workers, if there are any. It costs a
+    // fence and a load while none sleeps; the first call after workers went to sleep takes
+    // them all off the count and wakes them with one system call.
+    void wakeSleepers() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);  // pairs with the fence in workerLoop()
+        if (_sleepers.load(std::memory_order_relaxed) != 0 &&
+            _sleepers.exchange(0, std::memory_order_relaxed) != 0) {
+            _epoch.fetch_add(1, std::memory_order_release);
+            _epoch.notify_all();
+        }
+    }
+
+    bool hasWork() const {
+        if (_injectedCount.load(std::memory_order_relaxed) != 0) return true;
+        for (const auto& worker : _workers) {
+            if (!worker->deque.emptyApprox()) return true;
+        }
+        return false;
+    }
+
+    // One task from the shared queue, for threads that are not workers.
+    Task* takeInjectedTask() {
+        if (_injectedCount.load(std::memory_order_relaxed) == 0) return nullptr;
+        std::lock_guard<std::mutex> lock(_injectedMutex);
+        if (_injected.empty()) return nullptr;
+        Task* task = _injected.front();
+        _injected.pop_front();
+        _injectedCount.store(_injected.size(), std::memory_order_relaxed);
+        return task;
+    }
+
+    // Takes a share of the shared queue: runs the first task and moves the others to the
+    // worker's own deque, where the rest of the workers can steal them.
+    Task* takeInjected(Worker& self) {
+        if (_injectedCount.load(std::memory_order_relaxed) == 0) return nullptr;
+        size_t taken = 0;
+        Task* first = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_injectedMutex);
+            if (_injected.empty()) return nullptr;
+            taken = std::min({ _injected.size() / _workers.size() + 1, _injected.size(), maxInjectedBatch });
+            first = _injected.front();
+            _injected.pop_front();
+            for (size_t i = 1; i < taken; ++i) {
+                self.deque.push(_injected.front());
+                _injected.pop_front();
+            }
+            _injectedCount.store(_injected.size(), std::memory_order_relaxed);
+        }
+        if (taken > 1) wakeSleepers();
+        return first;
+    }
+
+    Task* findWork(unsigned index) {
+        Worker& self = *_workers[index];
+        if (Task* task = self.deque.pop()) return task;
+        if (Task* task = takeInjected(self)) return task;
+
+        size_t count = _workers.size();
+        self.random ^= self.random << 13;
+        self.random ^= self.random >> 17;
+        self.random ^= self.random << 5;
+        size_t start = self.random % count;
+        for (size_t i = 0; i < count; ++i) {
+            size_t victim = (start + i) % count;
+            if (victim == index) continue;
+            if (Task* task = _workers[victim]->deque.steal()) return task;
+        }
+        return nullptr;
+    }
+
+    void workerLoop(unsigned index) {
+        context() = { this, index };
+        _workers[index]->random = 0x9e3779b9u * (index + 1);
+        // on a single hardware thread the pushing thread cannot run while we spin
+        static const int spins = std::thread::hardware_concurrency() > 1 ? spinCount : 0;
+
+        for (;;) {
+            if (Task* task = findWork(index)) {
+                task->run();
+                continue;
+            }
+
+            bool found = false;
+            for (int i = 0; i < spins && !found; ++i) {
+                cpuRelax();
+                found = hasWork();
+            }
+            for (int i = 0; i < yieldCount && !found; ++i) {
+                std::this_thread::yield();
+                found = hasWork();
+            }
+            if (found) continue;
+            if (_stop.load(std::memory_order_acquire)) return;
+
+            // sleep until push() or the destructor changes the epoch
+            std::uint32_t epoch = _epoch.load(std::memory_order_acquire);
+            _sleepers.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);  // pairs with the fence in wakeSleepers()
+            // a worker that does not sleep after all stays counted (as in SpinThenPark): the
+            // count may already belong to workers that registered after wakeSleepers() cleared
+            // it. The cost is one needless wake-up call.
+            if (hasWork() || _stop.load(std::memory_order_relaxed)) continue;
+            _epoch.wait(epoch, std::memory_order_acquire);
+        }
+    }
+};
+
+namespace executor_detail {
+
+// The shared result slot behind a Future, reference counted: the future holds one
+// reference and whatever will produce the result (a queued task, a coroutine) another.
+class StateBase {
+public:
+    StateBase() = default;
+    StateBase(const StateBase&) = delete;
+    StateBase& operator=(const StateBase&) = delete;
+    virtual ~StateBase() = default;
+
+    void addRef() { _refs.fetch_add(1, std::memory_order_relaxed); }
+
+    void release() {
+        if (_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    bool ready() const { return _status.load(std::memory_order_acquire) == ready_; }
+
+    // Waits for the result. A worker thread runs other queued tasks meanwhile (it may be
+    // the only one that could run the task it waits for); other threads spin briefly and
+    // then block.
+    void wait() {
+        if (ready()) return;
+        if (Executor* executor = Executor::ofThisThread()) {
+            while (!ready()) {
+                if (!executor->runOne()) std::this_thread::yield();
+            }
+            return;
+        }
+        static const int spins = std::thread::hardware_concurrency() > 1 ? 1024 : 0;
+        for (int i = 0; i < spins; ++i) {
+            if (ready()) return;
+            cpuRelax();
+        }
+        for (std::uint32_t status = _status.load(std::memory_order_acquire); status != ready_;
+             status = _status.load(std::memory_order_acquire)) {
+            if (status == pending &&
+                !_status.compare_exchange_weak(status, pendingWithWaiters, std::memory_order_relaxed)) {
+                continue;
+            }
+            _status.wait(pendingWithWaiters, std::memory_order_acquire);
+        }
+    }
+
+    // Arranges for continuation->onReady() once the result is set; false if it already
+    // is. A state takes at most one continuation.
+    bool tryContinueWith(Continuation* continuation) {
+        Continuation* expected = nullptr;
+        return _continuation.compare_exchange_strong(expected, continuation, std::memory_order_acq_rel,
+                                                     std::memory_order_acquire);
+    }
+
+    void continueWith(Continuation* continuation) {
+        if (!tryContinueWith(continuation)) continuation->onReady();
+    }
+
+    void fail(std::exception_ptr error) { _error = std::move(error); }
+    const std::exception_ptr& error() const { return _error; }
+
+    // publishes the value or error stored before, wakes the waiters, runs the continuation
+    void complete() {
+        if (_status.exchange(ready_, std::memory_order_acq_rel) == pendingWithWaiters) {
+            _status.notify_all();
+        }
+        Continuation* continuation = _continuation.exchange(completed(), std::memory_order_acq_rel);
+        if (continuation) continuation->onReady();
+    }
+
+private:
+    static constexpr std::uint32_t pending = 0;
+    static constexpr std::uint32_t pendingWithWaiters = 1;
+    static constexpr std::uint32_t ready_ = 2;
+
+    std::atomic<std::uint32_t> _refs{ 1 };
+    std::atomic<std::uint32_t> _status{ pending };
+    std::atomic<Continuation*> _continuation{ nullptr };
+    std::exception_ptr _error;
+
+    // marks a completed state, so a late continuation is not stored
+    static Continuation* completed() {
+        struct Completed final : Continuation {
+            void onReady() override {}
+        };
+        static Completed marker;
+        return &marker;
+    }
+};
+
+template <typename T>
+class State : public StateBase {
+public:
+    template <typename... Args>
+    void emplace(Args&&... args) { _value.emplace(std::forward<Args>(args)...); }
+
+    // the value (moved out) or the stored exception
+    T take() {
+        if (error()) std::rethrow_exception(error());
+        return std::move(*_value);
+    }
+
+private:
+    std::optional<T> _value;
+};
+
+template <>
+class State<void> : public StateBase {
+public:
+    void emplace() {}
+
+    void take() {
+        if (error()) std::rethrow_exception(error());
+    }
+};
+
+// stores the result of f() (or its exception) in state and completes it
+template <typename T, typename F>
+void fulfil(State<T>& state, F&& f) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            f();
+            state.emplace();
+        } else {
+            state.emplace(f());
+        }
+    } catch (...) {
+        state.fail(std::current_exception());
+    }
+    state.complete();
+}
+
+// a spawned function together with the state of its result: one allocation per spawn
+template <typename T, typename F>
+class Job final : public State<T>, public Task {
+public:
+    template <typename G>
+    explicit Job(G&& function) : _function(std::forward<G>(function)) {
+        this->addRef();  // held by the queue until run() has finished
+    }
+
+    void run() override {
+        fulfil(*this, _function);
+        this->release();
+    }
+
+private:
+    F _function;
+};
+
+// function(value of antecedent), queued on the executor once the antecedent is ready;
+// an exception of the antecedent is passed on without calling function
+template <typename U, typename T, typename F>
+class ThenJob final : public State<U>, public Task, public Continuation {
+public:
+    template <typename G>
+    ThenJob(Executor& executor, State<T>* antecedent, G&& function)
+        : _executor(executor), _antecedent(antecedent), _function(std::forward<G>(function)) {
+        this->addRef();  // held until run() has finished
+    }
+
+    void start() { _antecedent->continueWith(this); }
+
+    void onReady() override { _executor.push(this); }
+
+    void run() override {
+        if (_antecedent->error()) {
+            this->fail(_antecedent->error());
+            this->complete();
+        } else {
+            fulfil(*this, [this]() -> U {
+                if constexpr (std::is_void_v<T>) {
+                    return std::invoke(_function);
+                } else {
+                    return std::invoke(_function, _antecedent->take());
+                }
+            });
+        }
+        _antecedent->release();
+        this->release();
+    }
+
+private:
+    Executor& _executor;
+    State<T>* _antecedent;
+    F _function;
+};
+
+// Coroutine promise of a Future<T>: the coroutine starts right away on the calling
+// thread and sets the future's result when it returns.
+template <typename T>
+class PromiseBase {
+public:
+    PromiseBase() : _state(new State<T>) {}
+    PromiseBase(const PromiseBase&) = delete;
+    PromiseBase& operator=(const PromiseBase&) = delete;
+    ~PromiseBase() { _state->release(); }
+
+    Future<T> get_return_object();
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() {
+        _state->fail(std::current_exception());
+        _state->complete();
+    }
+
+protected:
+    State<T>* _state;
+};
+
+template <typename T>
+class Promise : public PromiseBase<T> {
+public:
+    template <typename V>
+    void return_value(V&& value) {
+        this->_state->emplace(std::forward<V>(value));
+        this->_state->complete();
+    }
+};
+
+template <>
+class Promise<void> : public PromiseBase<void> {
+public:
+    void return_void() { _state->complete(); }
+};
+
+} // namespace executor_detail
+
+// The result of a task, available later. Futures are move-only; get(), then() and
+// co_await consume the future (it is no longer valid() afterwards).
+template <typename T>
+class Future {
+public:
+    using promise_type = executor_detail::Promise<T>;
+
+    Future() = default;
+
+    Future(Future&& other) noexcept : _state(std::exchange(other._state, nullptr)) {}
+
+    Future& operator=(Future&& other) noexcept {
+        if (this != &other) {
+            reset();
+            _state = std::exchange(other._state, nullptr);
+        }
+        return *this;
+    }
+
+    ~Future() { reset(); }
+
+    bool valid() const { return _state != nullptr; }
+    bool ready() const { return _state->ready(); }
+    void wait() const { _state->wait(); }
+
+    // waits for the result and returns it, or rethrows the exception of the task
+    T get() {
+        wait();
+        Owner state(std::exchange(_state, nullptr));
+        return state->take();
+    }
+
+    // Runs f(value) as a task once the result is set (f() for a Future<void>) and returns
+    // the future of f's result. No thread waits in between. If this future holds an
+    // exception, f is not called and the exception is passed on.
+    template <typename F>
+    auto then(F&& f, Executor& executor = Executor::current()) {
+        using Function = std::decay_t<F>;
+        using U = typename Result<Function>::type;
+        auto* job = new executor_detail::ThenJob<U, T, Function>(executor, std::exchange(_state, nullptr),
+                                                                 std::forward<F>(f));
+        Future<U> next(job);
+        job->start();
+        return next;
+    }
+
+    // co_await future: suspends the coroutine until the result is set, then resumes it
+    // on a worker of the awaiting thread's executor (global() outside of workers)
+    auto operator co_await() {
+        struct Awaiter final : executor_detail::Task, executor_detail::Continuation {
+            Owner state;
+            Executor& executor;
+            std::coroutine_handle<> handle;
+
+            Awaiter(executor_detail::State<T>* state, Executor& executor) : state(state), executor(executor) {}
+            bool await_ready() const { return state->ready(); }
+            bool await_suspend(std::coroutine_handle<> h) {
+                handle = h;
+                return state->tryContinueWith(this);
+            }
+            T await_resume() { return state->take(); }
+            void onReady() override { executor.push(this); }
+            void run() override { handle.resume(); }
+        };
+        return Awaiter(std::exchange(_state, nullptr), Executor::current());
+    }
+
+private:
+    template <typename>
+    friend class Future;
+    friend class Executor;
+    friend class executor_detail::PromiseBase<T>;
+    template <typename U>
+    friend Future<std::vector<Future<U>>> when_all(std::vector<Future<U>> futures);
+    template <typename U>
+    friend auto when_any(std::vector<Future<U>> futures);
+
+    struct Releaser {
+        void operator()(executor_detail::StateBase* state) const { state->release(); }
+    };
+    using Owner = std::unique_ptr<executor_detail::State<T>, Releaser>;
+
+    template <typename F>
+    struct Result {
+        using type = std::invoke_result_t<F&, T>;
+    };
+    template <typename F>
+        requires std::is_void_v<T>
+    struct Result<F> {
+        using type = std::invoke_result_t<F&>;
+    };
+
+    executor_detail::State<T>* _state = nullptr;
+
+    explicit Future(executor_detail::State<T>* state) : _state(state) {}
+
+    void reset() {
+        if (_state) std::exchange(_state, nullptr)->release();
+    }
+};
+
+template <typename T>
+Future<T> executor_detail::PromiseBase<T>::get_return_object() {
+    _state->addRef();
+    return Future<T>(_state);
+}
+
+template <typename F>
+auto Executor::spawn(F&& f) {
+    using Function = std::decay_t<F>;
+    using T = std::invoke_result_t<Function&>;
+    auto* job = new executor_detail::Job<T, Function>(std::forward<F>(f));
+    Future<T> future(job);
+    push(job);
+    return future;
+}
+
+// A future that is ready once all of futures are; it holds them, in the same order,
+// each with its own value or exception.
+template <typename T>
+Future<std::vector<Future<T>>> when_all(std::vector<Future<T>> futures) {
+    using Futures = std::vector<Future<T>>;
+    struct WhenAll final : executor_detail::State<Futures>, executor_detail::Continuation {
+        Futures futures;
+        std::atomic<size_t> remaining;
+
+        explicit WhenAll(Futures inputs) : futures(std::move(inputs)), remaining(futures.size() + 1) {
+            this->addRef();  // held until complete
+        }
+
+        void onReady() override {
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                this->emplace(std::move(futures));
+                this->complete();
+                this->release();
+            }
+        }
+    };
+
+    auto* all = new WhenAll(std::move(futures));
+    Future<Futures> result(all);
+    for (Future<T>& future : all->futures) {
+        future._state->continueWith(all);
+    }
+    all->onReady();  // the count started one higher so that the loop above finishes first
+    return result;
+}
+
+template <typename T>
+struct WhenAnyResult {
+    static constexpr size_t none = size_t(-1);
+
+    size_t index;  // of the first future that became ready, or none if there were no futures
+    std::vector<Future<T>> futures;
+};
+
+// A future that is ready once any of futures is; it holds all of them and the index of
+// that one.
+template <typename T>
+auto when_any(std::vector<Future<T>> futures) {
+    using Result = WhenAnyResult<T>;
+    struct WhenAny final : executor_detail::State<Result> {
+        struct Notifier final : executor_detail::Continuation {
+            WhenAny* owner = nullptr;
+            size_t index = 0;
+            void onReady() override { owner->arrived(index); }
+        };
+
+        std::vector<Future<T>> futures;
+        std::vector<Notifier> notifiers;
+        std::atomic<size_t> winner{ Result::none };
+        std::atomic<int> gate{ 2 };  // the first arrival and the end of registration
+
+        explicit WhenAny(std::vector<Future<T>> inputs) : futures(std::move(inputs)), notifiers(futures.size()) {
+            for (size_t i = 0; i < notifiers.size(); ++i) {
+                notifiers[i].owner = this;
+                notifiers[i].index = i;
+                this->addRef();  // one per notifier, which every input calls once
+            }
+        }
+
+        void arrived(size_t index) {
+            size_t expected = Result::none;
+            if (winner.compare_exchange_strong(expected, index, std::memory_order_acq_rel)) {
+                pass();
+            }
+            this->release();
+        }
+
+        void pass() {
+            if (gate.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                this->emplace(Result{ winner.load(std::memory_order_acquire), std::move(futures) });
+                this->complete();
+            }
+        }
+    };
+
+    auto* any = new WhenAny(std::move(futures));
+    Future<Result> result(any);
+    any->addRef();  // for the registration below
+    for (size_t i = 0; i < any->futures.size(); ++i) {
+        any->futures[i]._state->continueWith(&any->notifiers[i]);
+    }
+    if (any->futures.empty()) any->pass();  // ready right away, without a winner
+    any->pass();
+    any->release();
+    return result;
+}
+
+#endif // EXECUTOR_H
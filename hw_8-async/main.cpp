@@ -1,25 +1,326 @@
-
 #include <iostream>
 #include <vector>
 #include <future>
 #include <numeric>
+#include <optional>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "executor.h"
+#include "parallel_reduce.h"
 
-// calculate the sum of all elements in a vector
+// calculate the sum of all elements in a vector, split over the threads of the pool
+// (a short vector is summed inline on the calling thread)
 long long calculateSum(const std::vector<int>& numbers) {
-    return std::accumulate(numbers.begin(), numbers.end(), 0LL);
+    return parallel_sum(std::span<const int>(numbers));
+}
+
+// Best time of f() over runs, in milliseconds
+template <typename F>
+double bestTime(int runs, F f) {
+    double best = 1e300;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+// Thread counts to measure: powers of two up to the number of hardware threads (at least 4)
+std::vector<unsigned> threadCounts() {
+    unsigned limit = std::max(ThreadPool::defaultConcurrency(), 4u);
+    std::vector<unsigned> counts;
+    for (unsigned t = 1; t < limit; t *= 2) counts.push_back(t);
+    counts.push_back(limit);
+    return counts;
+}
+
+void printRow(const std::string& name, double ms, size_t bytes) {
+    std::cout << "  " << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << ms << " ms" << std::setw(7) << bytes / (ms / 1000) / 1e9 << " GB/s";
+}
+
+// int sums: the original single std::async, inline std::accumulate and parallel_sum
+// on pools of growing size; every parallel sum must equal the sequential one
+bool benchmarkIntegerSum(size_t elements) {
+    std::vector<int> numbers;
+    try {
+        numbers.assign(elements, 0);
+    } catch (const std::bad_alloc&) {
+        std::cout << "\nNot enough memory for " << elements << " ints\n";
+        return true;
+    }
+    for (size_t i = 0; i < elements; ++i) {
+        numbers[i] = static_cast<int>(i % 2001) - 1000 + (i % 7 == 0 ? 1 << 30 : 0);
+    }
+    size_t bytes = elements * sizeof(int);
+    std::cout << "\nint sum of " << elements << " elements (best of 3):\n";
+
+    long long expected = 0;
+    printRow("std::accumulate", bestTime(3, [&] {
+        expected = std::accumulate(numbers.begin(), numbers.end(), 0LL);
+    }), bytes);
+    std::cout << "\n";
+    printRow("std::async(accumulate)", bestTime(3, [&] {
+        std::async(std::launch::async, [&] { return std::accumulate(numbers.begin(), numbers.end(), 0LL); }).get();
+    }), bytes);
+    std::cout << "\n";
+
+    bool correct = true;
+    for (unsigned threads : threadCounts()) {
+        ThreadPool pool(threads);
+        long long sum = 0;
+        double ms = bestTime(3, [&] { sum = parallel_sum(std::span<const int>(numbers), pool); });
+        printRow("parallel_sum, " + std::to_string(threads) + " threads", ms, bytes);
+        std::cout << (sum == expected ? "\n" : "   WRONG SUM\n");
+        correct = correct && sum == expected;
+    }
+    return correct;
+}
+
+// float sums in each mode: time, relative error against a double-precision reference,
+// and whether the result is bit-identical for every thread count
+bool benchmarkFloatSum(size_t elements) {
+    std::vector<float> values;
+    try {
+        values.assign(elements, 0.0f);
+    } catch (const std::bad_alloc&) {
+        std::cout << "\nNot enough memory for " << elements << " floats\n";
+        return true;
+    }
+    for (size_t i = 0; i < elements; ++i) {
+        values[i] = 0.1f + static_cast<float>(i % 1000) * 1e-4f;
+    }
+    size_t bytes = elements * sizeof(float);
+    std::span<const float> data(values);
+
+    double reference = 0;
+    {
+        // exact enough: the float inputs summed with Kahan in double precision
+        double lost = 0;
+        for (float value : values) {
+            double adjusted = value - lost;
+            double next = reference + adjusted;
+            lost = (next - reference) - adjusted;
+            reference = next;
+        }
+    }
+    std::cout << "\nfloat sum of " << elements << " elements (best of 3, all threads):\n";
+
+    auto relativeError = [reference](double sum) {
+        return reference == 0 ? std::abs(sum) : std::abs(sum - reference) / std::abs(reference);
+    };
+    float sequential = 0;
+    printRow("std::accumulate", bestTime(3, [&] {
+        sequential = std::accumulate(values.begin(), values.end(), 0.0f);
+    }), bytes);
+    std::cout << "   error " << std::scientific << std::setprecision(2) << relativeError(sequential) << "\n";
+
+    const std::pair<FloatSum, const char*> modes[] = {
+        { FloatSum::Naive, "parallel_sum naive" },
+        { FloatSum::Pairwise, "parallel_sum pairwise" },
+        { FloatSum::Kahan, "parallel_sum Kahan" },
+    };
+    bool reproducible = true;
+    for (auto [mode, name] : modes) {
+        float sum = 0;
+        double ms = bestTime(3, [&] { sum = parallel_sum(data, mode); });
+        bool identical = true;
+        for (unsigned threads : threadCounts()) {
+            ThreadPool pool(threads);
+            identical = identical && parallel_sum(data, mode, pool) == sum;
+        }
+        printRow(name, ms, bytes);
+        std::cout << "   error " << std::scientific << std::setprecision(2) << relativeError(sum)
+                  << (identical ? "   same for every thread count\n" : "   DEPENDS ON THREAD COUNT\n");
+        reproducible = reproducible && identical;
+    }
+    return reproducible;
+}
+
+using Clock = std::chrono::steady_clock;
+
+double nanoseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::nano>(duration).count();
+}
+
+double percentile(std::vector<double> samples, double fraction) {
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+// Time from spawning a task to its start, and from spawning it to having its result
+template <typename Spawn>
+void measureSpawnLatency(const std::string& name, int runs, Spawn spawnAndGet) {
+    std::vector<double> starts;
+    std::vector<double> roundTrips;
+    for (int run = 0; run < runs; ++run) {
+        Clock::time_point spawned = Clock::now();
+        Clock::time_point started = spawnAndGet([] { return Clock::now(); });
+        starts.push_back(nanoseconds(started - spawned));
+        roundTrips.push_back(nanoseconds(Clock::now() - spawned));
+    }
+    std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(0)
+              << "start " << std::setw(8) << percentile(starts, 0.5) << " ns median " << std::setw(8)
+              << percentile(starts, 0.99) << " ns p99   round trip " << std::setw(8) << percentile(roundTrips, 0.5)
+              << " ns median\n";
 }
 
-int main() {
+void printThroughput(const std::string& name, size_t tasks, double ms, bool correct) {
+    std::cout << "  " << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << ms << " ms" << std::setw(9) << tasks / ms / 1000 << " M tasks/s" << std::setw(9)
+              << ms * 1e6 / tasks << " ns/task" << (correct ? "\n" : "   WRONG RESULT\n");
+}
+
+// Sum of 2 * i for i in [begin, end): every call is a task of its own (it moves itself
+// onto the executor first), and the halves are split further by the workers that run them
+Future<std::int64_t> sumTree(Executor& executor, std::int64_t begin, std::int64_t end) {
+    co_await executor.schedule();
+    if (end - begin == 1) co_return 2 * begin;
+    std::int64_t middle = begin + (end - begin) / 2;
+    Future<std::int64_t> left = sumTree(executor, begin, middle);
+    std::int64_t right = co_await sumTree(executor, middle, end);
+    co_return co_await std::move(left) + right;
+}
+
+// count tiny tasks (each returns 2 * i) through std::async and through the executor
+bool runTaskBenchmarks(size_t count) {
+    Executor executor;
+    std::int64_t expected = static_cast<std::int64_t>(count) * (static_cast<std::int64_t>(count) - 1);
+
+    std::cout << "Spawn latency (" << executor.concurrency() << " executor threads):\n";
+    measureSpawnLatency("std::async", 2000, [](auto task) { return std::async(std::launch::async, task).get(); });
+    measureSpawnLatency("Executor", 20000, [&](auto task) { return executor.spawn(task).get(); });
+
+    std::cout << "\n" << count << " tiny tasks:\n";
+    bool correct = true;
+    auto report = [&](const std::string& name, double ms, std::int64_t sum) {
+        printThroughput(name, count, ms, sum == expected);
+        correct = correct && sum == expected;
+    };
+
+    // at most 1000 threads at a time: every std::async task is a thread of its own
+    std::int64_t sum = 0;
+    double ms = bestTime(1, [&] {
+        sum = 0;
+        constexpr size_t wave = 1000;
+        std::vector<std::future<std::int64_t>> futures;
+        for (size_t first = 0; first < count; first += wave) {
+            for (size_t i = first; i < std::min(count, first + wave); ++i) {
+                futures.push_back(std::async(std::launch::async, [i] { return 2 * static_cast<std::int64_t>(i); }));
+            }
+            for (auto& future : futures) sum += future.get();
+            futures.clear();
+        }
+    });
+    report("std::async, 1000 at a time", ms, sum);
+
+    ms = bestTime(3, [&] {
+        sum = 0;
+        std::vector<Future<std::int64_t>> futures;
+        futures.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            futures.push_back(executor.spawn([i] { return 2 * static_cast<std::int64_t>(i); }));
+        }
+        for (auto& future : futures) sum += future.get();
+    });
+    report("Executor spawn + get", ms, sum);
+
+    ms = bestTime(3, [&] {
+        std::vector<Future<std::int64_t>> futures;
+        futures.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            futures.push_back(executor.spawn([i] { return 2 * static_cast<std::int64_t>(i); }));
+        }
+        sum = when_all(std::move(futures)).then([](std::vector<Future<std::int64_t>> done) {
+            std::int64_t total = 0;
+            for (auto& future : done) total += future.get();
+            return total;
+        }, executor).get();
+    });
+    report("Executor spawn + when_all", ms, sum);
+
+    ms = bestTime(3, [&] { sum = count == 0 ? 0 : sumTree(executor, 0, static_cast<std::int64_t>(count)).get(); });
+    report("coroutine tree (stealing)", ms, sum);
+
+    // each continuation is queued by the task before it: a chain that no thread waits on
+    ms = bestTime(3, [&] {
+        Future<std::int64_t> chain = executor.spawn([] { return std::int64_t(0); });
+        for (size_t i = 0; i < count; ++i) {
+            chain = chain.then([i](std::int64_t total) { return total + 2 * static_cast<std::int64_t>(i); }, executor);
+        }
+        sum = chain.get();
+    });
+    report("then() chain", ms, sum);
+    return correct;
+}
+
+// argv[index] as a count, fallback if it is missing, nullopt if it is not a number
+std::optional<size_t> countArgument(int argc, char* argv[], int index, size_t fallback) {
+    if (argc <= index) return fallback;
+    const char* text = argv[index];
+    if (*text < '0' || *text > '9') return std::nullopt;  // stoull would accept "-1" and " 1"
+    try {
+        size_t length = 0;
+        unsigned long long value = std::stoull(text, &length);
+        if (text[length] != '\0') return std::nullopt;
+        return static_cast<size_t>(value);
+    } catch (const std::logic_error&) {  // std::out_of_range
+        return std::nullopt;
+    }
+}
+
+int printUsage() {
+    std::cerr << "Usage: hw8 [tasks [count] | bench [elements]]" << std::endl;
+    return 1;
+}
+
+// hw8: the example
+// hw8 bench [elements]: integer and float sum benchmarks on elements values (default 10^9)
+// hw8 tasks [count]: task spawn latency and throughput of count tasks (default 10^6)
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "tasks") {
+        std::optional<size_t> count = countArgument(argc, argv, 2, 1'000'000);
+        if (!count) return printUsage();
+        return runTaskBenchmarks(*count) ? 0 : 1;
+    }
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        std::optional<size_t> elements = countArgument(argc, argv, 2, 1'000'000'000);
+        if (!elements) return printUsage();
+        bool correct = benchmarkIntegerSum(*elements);
+        bool reproducible = benchmarkFloatSum(*elements);
+        return correct && reproducible ? 0 : 1;
+    }
+
     std::vector<int> numbers = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
 
-    // Launch a separate thread to calculate the sum using std::async
-    std::future<long long> resultFuture = std::async(std::launch::async, calculateSum, std::ref(numbers));
+    // The sum runs as a task on the executor's threads, which are started once; the
+    // message is built by a continuation when the sum is ready, so no thread waits for it
+    Future<std::string> message = Executor::global().spawn([&numbers] { return calculateSum(numbers); })
+        .then([](long long sum) { return "The sum of the vector elements is: " + std::to_string(sum); });
 
     // Wait for the result and retrieve it
-    long long result = resultFuture.get();
+    std::cout << message.get() << std::endl;
 
-    // Output the result to the console
-    std::cout << "The sum of the vector elements is: " << result << std::endl;
+    // sums that do not fit in 64 bits are reported instead of wrapping around
+    std::vector<std::int64_t> large = { std::numeric_limits<std::int64_t>::max(), 1 };
+    try {
+        parallel_sum(std::span<const std::int64_t>(large));
+    } catch (const std::overflow_error& error) {
+        std::cout << "Overflow detected: " << error.what() << std::endl;
+    }
 
     return 0;
 }
@@ -0,0 +1,252 @@
+#ifndef PARALLEL_REDUCE_H
+#define PARALLEL_REDUCE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "thread_pool.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARALLEL_REDUCE_SSE2 1
+#endif
+
+// Largest leaf of the split: big enough that claiming one is negligible, small enough
+// that the threads finish together
+constexpr size_t reduceLeafSize = 64 * 1024;
+
+enum class FloatSum {
+    Naive,     // eight running sums: fastest, the error grows with the length
+    Pairwise,  // blocks added in a balanced tree: the error grows with log(length)
+    Kahan,     // compensated running sums (Neumaier): the error does not grow with the length
+};
+
+// The range [0, count) is halved until the pieces have at most reduceLeafSize elements;
+// leaf(begin, end) is called for each piece on the pool's threads and the results are
+// combined pairwise along the same tree. The tree depends only on count, never on the
+// number of threads or the order they finish in, so a non-associative combine (floating
+// point) gives the same result on every run. Returns leaf(0, 0) for an empty range.
+template <typename Leaf, typename Combine>
+auto parallel_reduce(size_t count, Leaf&& leaf, Combine&& combine, ThreadPool& pool = ThreadPool::global()) {
+    using Partial = decltype(leaf(size_t(0), size_t(0)));
+    size_t leaves = std::bit_ceil(std::max<size_t>((count + reduceLeafSize - 1) / reduceLeafSize, 1));
+    if (leaves == 1) return leaf(size_t(0), count);
+
+    // leaf i starts at count * i / leaves, written so that it cannot overflow
+    size_t quotient = count / leaves;
+    size_t remainder = count % leaves;
+    auto boundary = [=](size_t i) { return quotient * i + remainder * i / leaves; };
+
+    std::vector<Partial> partials(leaves);
+    struct alignas(cacheLineSize) Cursor {
+        std::atomic<size_t> next{ 0 };
+    } cursor;
+    unsigned threads = static_cast<unsigned>(std::min<size_t>(pool.concurrency(), leaves));
+    pool.run(threads, [&](unsigned) {
+        for (size_t i; (i = cursor.next.fetch_add(1, std::memory_order_relaxed)) < leaves;) {
+            partials[i] = leaf(boundary(i), boundary(i + 1));
+        }
+    });
+
+    for (size_t width = 1; width < leaves; width *= 2) {
+        for (size_t i = 0; i < leaves; i += 2 * width) {
+            partials[i] = combine(partials[i], partials[i + width]);
+        }
+    }
+    return partials[0];
+}
+
+namespace reduce_detail {
+
+// a + b, or false if it does not fit in an int64
+inline bool checkedAdd(std::int64_t a, std::int64_t b, std::int64_t& sum) {
+    auto wrapped = static_cast<std::int64_t>(static_cast<std::uint64_t>(a) + static_cast<std::uint64_t>(b));
+    sum = wrapped;
+    return ((a ^ wrapped) & (b ^ wrapped)) >= 0;  // overflow flips the sign away from both operands
+}
+
+struct IntegerPartial {
+    std::int64_t sum = 0;
+    bool overflow = false;
+};
+
+inline IntegerPartial combine(IntegerPartial a, IntegerPartial b) {
+    IntegerPartial result;
+    result.overflow = a.overflow || b.overflow || !checkedAdd(a.sum, b.sum, result.sum);
+    return result;
+}
+
+// Integers of up to 32 bits: a leaf has far fewer than 2^32 elements, so its int64
+// running sums cannot overflow and need no checks.
+template <typename T>
+IntegerPartial sumNarrow(const T* data, size_t count) {
+    constexpr size_t lanes = 8;
+    std::int64_t acc[lanes] = {};
+    size_t i = 0;
+#ifdef PARALLEL_REDUCE_SSE2
+    if constexpr (sizeof(T) == 4) {
+        // four 2-lane int64 sums; each loaded int32 is widened by interleaving it with
+        // its sign (or zero) so that the adds cannot carry between elements
+        __m128i sums[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+        for (; i + lanes <= count; i += lanes) {
+            __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 4));
+            __m128i lowExtension = std::is_signed_v<T> ? _mm_srai_epi32(low, 31) : _mm_setzero_si128();
+            __m128i highExtension = std::is_signed_v<T> ? _mm_srai_epi32(high, 31) : _mm_setzero_si128();
+            sums[0] = _mm_add_epi64(sums[0], _mm_unpacklo_epi32(low, lowExtension));
+            sums[1] = _mm_add_epi64(sums[1], _mm_unpackhi_epi32(low, lowExtension));
+            sums[2] = _mm_add_epi64(sums[2], _mm_unpacklo_epi32(high, highExtension));
+            sums[3] = _mm_add_epi64(sums[3], _mm_unpackhi_epi32(high, highExtension));
+        }
+        for (size_t k = 0; k < 4; ++k) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 2 * k), sums[k]);
+        }
+    }
+#endif
+    for (; i + lanes <= count; i += lanes) {
+        for (size_t k = 0; k < lanes; ++k) acc[k] += data[i + k];
+    }
+    for (; i < count; ++i) acc[i % lanes] += data[i];
+
+    IntegerPartial result;
+    for (std::int64_t lane : acc) result.sum += lane;
+    return result;
+}
+
+// 64-bit integers: every add is checked; the overflow flags of the lanes are or-ed
+// without a branch so that the loop stays vectorizable
+inline IntegerPartial sumWide(const std::int64_t* data, size_t count) {
+    constexpr size_t lanes = 4;
+    std::uint64_t acc[lanes] = {};
+    std::uint64_t overflow = 0;
+    size_t i = 0;
+    auto add = [&](size_t k, std::int64_t value) {
+        std::uint64_t x = static_cast<std::uint64_t>(value);
+        std::uint64_t sum = acc[k] + x;
+        overflow |= (~(acc[k] ^ x) & (acc[k] ^ sum)) >> 63;
+        acc[k] = sum;
+    };
+    for (; i + lanes <= count; i += lanes) {
+        for (size_t k = 0; k < lanes; ++k) add(k, data[i + k]);
+    }
+    for (; i < count; ++i) add(i % lanes, data[i]);
+
+    IntegerPartial result{ 0, overflow != 0 };
+    for (std::uint64_t lane : acc) result = combine(result, { static_cast<std::int64_t>(lane), false });
+    return result;
+}
+
+// a floating point sum as value + correction (the low-order bits value could not hold)
+template <typename T>
+struct FloatPartial {
+    T value = 0;
+    T correction = 0;
+};
+
+// adds two compensated sums, keeping the rounding error of the addition (Neumaier)
+template <typename T>
+FloatPartial<T> combine(FloatPartial<T> a, FloatPartial<T> b) {
+    T sum = a.value + b.value;
+    T error = std::abs(a.value) >= std::abs(b.value) ? (a.value - sum) + b.value : (b.value - sum) + a.value;
+    return { sum, a.correction + b.correction + error };
+}
+
+template <typename T>
+T sumNaive(const T* data, size_t count) {
+    constexpr size_t lanes = 8;
+    T acc[lanes] = {};
+    size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+        for (size_t k = 0; k < lanes; ++k) acc[k] += data[i + k];
+    }
+    for (; i < count; ++i) acc[i % lanes] += data[i];
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+template <typename T>
+T sumPairwise(const T* data, size_t count) {
+    constexpr size_t block = 256;  // the naive sum of a block is still accurate
+    if (count <= block) return sumNaive(data, count);
+    size_t half = count / 2;
+    return sumPairwise(data, half) + sumPairwise(data + half, count - half);
+}
+
+// Compensated summation in eight independent lanes, in the Kahan-Babuska (Neumaier)
+// form: the bits lost by each addition are kept in a separate sum, which stays correct
+// when a large value follows many small ones (plain Kahan then drops the compensation).
+// It relies on the exact order of the operations: it does not survive -ffast-math or /fp:fast.
+template <typename T>
+FloatPartial<T> sumKahan(const T* data, size_t count) {
+    constexpr size_t lanes = 8;
+    T sum[lanes] = {};
+    T lost[lanes] = {};
+    auto add = [&](size_t k, T value) {
+        T next = sum[k] + value;
+        bool sumIsLarger = std::abs(sum[k]) >= std::abs(value);
+        T large = sumIsLarger ? sum[k] : value;
+        T small = sumIsLarger ? value : sum[k];
+        lost[k] += (large - next) + small;
+        sum[k] = next;
+    };
+    size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+        for (size_t k = 0; k < lanes; ++k) add(k, data[i + k]);
+    }
+    for (; i < count; ++i) add(i % lanes, data[i]);
+
+    FloatPartial<T> result;
+    for (size_t k = 0; k < lanes; ++k) result = combine(result, FloatPartial<T>{ sum[k], lost[k] });
+    return result;
+}
+
+} // namespace reduce_detail
+
+// Sum of integers as an int64, computed on the pool's threads.
+// Throws std::overflow_error if the sum (or a partial sum) does not fit.
+template <std::integral T>
+std::int64_t parallel_sum(std::span<const T> values, ThreadPool& pool = ThreadPool::global()) {
+    static_assert(sizeof(T) <= 4 || std::is_signed_v<T>, "64-bit unsigned values do not fit an int64 sum");
+    auto partial = parallel_reduce(values.size(), [values](size_t begin, size_t end) {
+        if constexpr (sizeof(T) <= 4) {
+            return reduce_detail::sumNarrow(values.data() + begin, end - begin);
+        } else {
+            return reduce_detail::sumWide(reinterpret_cast<const std::int64_t*>(values.data()) + begin, end - begin);
+        }
+    }, [](reduce_detail::IntegerPartial a, reduce_detail::IntegerPartial b) {
+        return reduce_detail::combine(a, b);
+    }, pool);
+    if (partial.overflow) {
+        throw std::overflow_error("parallel_sum: the sum does not fit in an int64");
+    }
+    return partial.sum;
+}
+
+// Sum of floating point values in the precision of T, computed on the pool's threads.
+// The result does not depend on the number of threads.
+template <std::floating_point T>
+T parallel_sum(std::span<const T> values, FloatSum mode = FloatSum::Pairwise, ThreadPool& pool = ThreadPool::global()) {
+    using Partial = reduce_detail::FloatPartial<T>;
+    auto partial = parallel_reduce(values.size(), [values, mode](size_t begin, size_t end) {
+        const T* data = values.data() + begin;
+        switch (mode) {
+        case FloatSum::Naive: return Partial{ reduce_detail::sumNaive(data, end - begin), 0 };
+        case FloatSum::Pairwise: return Partial{ reduce_detail::sumPairwise(data, end - begin), 0 };
+        default: return reduce_detail::sumKahan(data, end - begin);
+        }
+    }, [mode](Partial a, Partial b) {
+        // the leaves are added along a balanced tree, which is already pairwise
+        return mode == FloatSum::Kahan ? reduce_detail::combine(a, b) : Partial{ a.value + b.value, 0 };
+    }, pool);
+    return partial.value + partial.correction;
+}
+
+#endif // PARALLEL_REDUCE_H
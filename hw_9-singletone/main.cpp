@@ -1,23 +1,33 @@
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <string>
+#include <thread>
+
+#include "service_registry.h"
 
 class Singleton {
 public:
+    // the registry constructs it on the first call; later calls load a cached pointer
     static Singleton& getInstance() {
-        std::call_once(initFlag, []() {
-            instance.reset(new Singleton());
-        });
-        return *instance;
+        return ServiceRegistry::get<Singleton>();
     }
 
     void doSomething() {
         std::cout << "Singleton is working!" << std::endl;
     }
 
+    void touch() { ++_uses; }
+
     ~Singleton() = default;
 
 private:
+    friend class ServiceAccess;
+
     Singleton() {
         std::cout << "Singleton instance created." << std::endl;
     }
@@ -25,19 +35,143 @@ private:
     Singleton(const Singleton&) = delete;
     Singleton& operator=(const Singleton&) = delete;
 
-    static std::unique_ptr<Singleton> instance;
+    std::uint64_t _uses = 0;
+};
+
+// The original implementation, kept for comparison: std::call_once and a unique_ptr
+// on every access
+class CallOnceSingleton {
+public:
+    static CallOnceSingleton& getInstance() {
+        std::call_once(initFlag, []() {
+            instance.reset(new CallOnceSingleton());
+        });
+        return *instance;
+    }
+
+    void touch() { ++_uses; }
+
+private:
+    CallOnceSingleton() = default;
+
+    static std::unique_ptr<CallOnceSingleton> instance;
     static std::once_flag initFlag;
+
+    std::uint64_t _uses = 0;
 };
 
-std::unique_ptr<Singleton> Singleton::instance;
-std::once_flag Singleton::initFlag;
+std::unique_ptr<CallOnceSingleton> CallOnceSingleton::instance;
+std::once_flag CallOnceSingleton::initFlag;
+
+// a function-local static: the compiler adds a guard check to every access
+class LocalStaticSingleton {
+public:
+    static LocalStaticSingleton& getInstance() {
+        static LocalStaticSingleton instance;
+        return instance;
+    }
+
+    void touch() { ++_uses; }
+
+private:
+    std::uint64_t _uses = 0;
+};
+
+// Services that depend on each other; the sleeps stand in for reading files and
+// opening connections.
+class Config {
+public:
+    Config() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::cout << "Config loaded." << std::endl;
+    }
+    ~Config() { std::cout << "Config released." << std::endl; }
+
+    std::string databaseUrl() const { return "db://localhost/hw9"; }
+};
+
+class Logger {
+public:
+    explicit Logger(Config&) { std::cout << "Logger started." << std::endl; }
+    ~Logger() { std::cout << "Logger stopped." << std::endl; }
+
+    void log(const std::string& message) { std::cout << "[log] " << message << std::endl; }
+};
+
+class Database {
+public:
+    Database(Config& config, Logger& logger) : _logger(logger) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        _logger.log("connected to " + config.databaseUrl());
+    }
+    // the logger is destroyed after the database, so it can still be used here
+    ~Database() { _logger.log("database connection closed"); }
+
+private:
+    Logger& _logger;
+};
+
+// Time per access of each kind of singleton, in nanoseconds
+template <typename Get>
+double nanosecondsPerCall(std::uint64_t calls, Get get) {
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < calls; ++i) {
+        get().touch();
+        // a compiler-only barrier: without it the access would be hoisted out of the loop
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / calls;
+}
+
+void runAccessBenchmark(std::uint64_t calls) {
+    std::cout << "\nAccess cost (" << calls << " calls, ns per call):\n" << std::fixed << std::setprecision(2);
+    std::cout << "  call_once + unique_ptr   " << nanosecondsPerCall(calls, [] () -> CallOnceSingleton& {
+        return CallOnceSingleton::getInstance();
+    }) << "\n";
+    std::cout << "  function-local static    " << nanosecondsPerCall(calls, [] () -> LocalStaticSingleton& {
+        return LocalStaticSingleton::getInstance();
+    }) << "\n";
+    std::cout << "  ServiceRegistry::get     " << nanosecondsPerCall(calls, [] () -> Singleton& {
+        return Singleton::getInstance();
+    }) << "\n";
+    Singleton& cached = Singleton::getInstance();
+    std::cout << "  reference held by caller " << nanosecondsPerCall(calls, [&cached] () -> Singleton& {
+        return cached;
+    }) << "\n";
+}
+
+// hw9: the example; hw9 bench [calls]: the cost of calls accesses (default 10^9)
+int main(int argc, char* argv[]) {
+    ServiceRegistry& registry = ServiceRegistry::global();
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        registry.add<Singleton>("Singleton");
+        Singleton::getInstance();  // created before the timing starts
+        std::uint64_t calls = argc > 2 ? std::stoull(argv[2]) : 1'000'000'000;
+        runAccessBenchmark(calls);
+        std::cout << std::endl;
+        registry.shutdown();
+        return 0;
+    }
+
+    registry.add<Singleton>("Singleton");
+    registry.add<Database, Config, Logger>("Database");  // lazy: opened on first use
+    registry.add<Logger, Config>("Logger", ServiceInit::Eager);
+    registry.add<Config>("Config", ServiceInit::Eager);
+    registry.start();  // Config, then Logger
 
-int main() {
     Singleton& s1 = Singleton::getInstance();
     s1.doSomething();
 
     Singleton& s2 = Singleton::getInstance();
     s2.doSomething();
 
+    ServiceRegistry::get<Database>();
+    std::cout << std::endl;
+    registry.printStartupReport(std::cout);
+
+    // Database, Singleton, Logger, Config: the reverse of construction
+    std::cout << std::endl;
+    registry.shutdown();
     return 0;
 }
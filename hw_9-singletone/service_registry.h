@@ -0,0 +1,220 @@
+#ifndef SERVICE_REGISTRY_H
+#define SERVICE_REGISTRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class ServiceInit {
+    Lazy,   // constructed on first use
+    Eager,  // constructed by ServiceRegistry::start()
+};
+
+// The registry creates and destroys services through this class, so a service can keep
+// its constructor and destructor private and declare `friend class ServiceAccess;`.
+class ServiceAccess {
+private:
+    friend class ServiceRegistry;
+
+    template <typename T>
+    static constexpr bool defaultConstructible = requires { new T(); };
+
+    template <typename T, typename... Args>
+    static T* create(Args&... args) { return new T(args...); }
+
+    template <typename T>
+    static void destroy(T* service) { delete service; }
+};
+
+// Process-wide services, one object per type. A service is constructed after the services
+// it depends on, and shutdown() (or the end of the program) destroys the services in the
+// reverse order of their construction, so a service can use its dependencies until it is
+// destroyed itself. Construction is timed, for finding what makes startup slow.
+//
+// get<T>() costs one load and a predictable branch once T exists: the pointer to it is
+// cached in a static slot of its own, and the lock is taken only to construct it.
+class ServiceRegistry {
+public:
+    struct StartupTime {
+        std::string name;
+        ServiceInit init;
+        std::chrono::nanoseconds total;  // including the construction of dependencies
+        std::chrono::nanoseconds own;    // the constructor of the service itself
+    };
+
+    static ServiceRegistry& global() {
+        static ServiceRegistry registry;
+        return registry;
+    }
+
+    ~ServiceRegistry() { shutdown(); }
+
+    // Registers T, to be constructed as T(Dependencies&...) once they all exist.
+    // A type used without registering is a lazy service without dependencies.
+    template <typename T, typename... Dependencies>
+    void add(std::string name, ServiceInit init = ServiceInit::Lazy) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        auto [position, inserted] = _index.try_emplace(std::type_index(typeid(T)), _entries.size());
+        if (!inserted) {
+            throw std::logic_error("service registered twice: " + name);
+        }
+        _entries.push_back({ std::move(name), init, &construct<T, Dependencies...>, &destroy<T>, State::Registered, {}, {} });
+    }
+
+    // the service of type T, constructed first if needed; throws std::logic_error when
+    // T (or one of its dependencies) depends on itself or is used after shutdown()
+    template <typename T>
+    static T& get() {
+        if (T* service = Slot<T>::service.load(std::memory_order_acquire)) {
+            return *service;
+        }
+        return global().getSlow<T>();
+    }
+
+    // constructs the eager services, in the order they were registered
+    void start() {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        for (size_t i = 0; i < _entries.size(); ++i) {
+            if (_entries[i].init == ServiceInit::Eager) constructEntry(i);
+        }
+    }
+
+    // Destroys the constructed services, the last constructed first. Other threads must
+    // have stopped using them.
+    void shutdown() {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _shutDown = true;
+        for (auto entry = _constructionOrder.rbegin(); entry != _constructionOrder.rend(); ++entry) {
+            Entry& e = _entries[*entry];
+            if (e.state != State::Ready) continue;
+            e.state = State::Destroyed;
+            e.destroy();
+        }
+    }
+
+    // construction times, in the order of construction
+    std::vector<StartupTime> startupTimes() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        std::vector<StartupTime> times;
+        for (size_t entry : _constructionOrder) {
+            const Entry& e = _entries[entry];
+            times.push_back({ e.name, e.init, e.total, e.own });
+        }
+        return times;
+    }
+
+    void printStartupReport(std::ostream& out) const {
+        std::chrono::nanoseconds sum{};
+        out << "Service startup (microseconds, in construction order):\n";
+        out << "  service               init     total       own\n";
+        for (const StartupTime& time : startupTimes()) {
+            out << "  " << std::left << std::setw(20) << time.name << std::setw(6)
+                << (time.init == ServiceInit::Eager ? "eager" : "lazy") << std::right << std::fixed
+                << std::setprecision(1) << std::setw(10) << time.total.count() / 1e3 << std::setw(10)
+                << time.own.count() / 1e3 << "\n";
+            sum += time.own;
+        }
+        out << "  all services              " << std::setw(10) << sum.count() / 1e3 << "\n";
+    }
+
+private:
+    enum class State { Registered, Constructing, Ready, Destroyed };
+
+    struct Entry {
+        std::string name;
+        ServiceInit init;
+        void (*construct)();
+        void (*destroy)();
+        State state;
+        std::chrono::nanoseconds total;
+        std::chrono::nanoseconds own;
+    };
+
+    template <typename T>
+    struct Slot {
+        static inline std::atomic<T*> service{ nullptr };
+    };
+
+    mutable std::recursive_mutex _mutex;  // recursive: constructing a service gets its dependencies
+    std::deque<Entry> _entries;           // a deque, so that registering does not move the others
+    std::unordered_map<std::type_index, size_t> _index;
+    std::vector<size_t> _constructionOrder;
+    std::chrono::nanoseconds _dependencyTime{};  // spent constructing dependencies of the current service
+    bool _shutDown = false;
+
+    ServiceRegistry() = default;
+    ServiceRegistry(const ServiceRegistry&) = delete;
+    ServiceRegistry& operator=(const ServiceRegistry&) = delete;
+
+    template <typename T, typename... Dependencies>
+    static void construct() {
+        (get<Dependencies>(), ...);  // in the order listed, before T
+        T* service = ServiceAccess::create<T>(get<Dependencies>()...);
+        Slot<T>::service.store(service, std::memory_order_release);
+    }
+
+    template <typename T>
+    static void destroy() {
+        ServiceAccess::destroy(Slot<T>::service.exchange(nullptr, std::memory_order_acq_rel));
+    }
+
+    template <typename T>
+    T& getSlow() {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        if (T* service = Slot<T>::service.load(std::memory_order_relaxed)) {
+            return *service;  // constructed by another thread meanwhile
+        }
+        auto position = _index.find(std::type_index(typeid(T)));
+        size_t entry = 0;
+        if (position != _index.end()) {
+            entry = position->second;
+        } else if constexpr (ServiceAccess::defaultConstructible<T>) {
+            add<T>(typeid(T).name());
+            entry = _entries.size() - 1;
+        } else {
+            throw std::logic_error(std::string("service not registered: ") + typeid(T).name());
+        }
+        constructEntry(entry);
+        return *Slot<T>::service.load(std::memory_order_relaxed);
+    }
+
+    void constructEntry(size_t entry) {
+        Entry& e = _entries[entry];
+        if (e.state == State::Ready) return;
+        if (_shutDown || e.state == State::Destroyed) {
+            throw std::logic_error("service used after shutdown: " + e.name);
+        }
+        if (e.state == State::Constructing) {
+            throw std::logic_error("service depends on itself: " + e.name);
+        }
+
+        e.state = State::Constructing;
+        std::chrono::nanoseconds outerDependencyTime = std::exchange(_dependencyTime, {});
+        auto start = std::chrono::steady_clock::now();
+        try {
+            e.construct();
+        } catch (...) {
+            e.state = State::Registered;
+            _dependencyTime = outerDependencyTime;
+            throw;
+        }
+        e.total = std::chrono::steady_clock::now() - start;
+        e.own = e.total - _dependencyTime;
+        _dependencyTime = outerDependencyTime + e.total;
+        e.state = State::Ready;
+        _constructionOrder.push_back(entry);
+    }
+};
+
+#endif // SERVICE_REGISTRY_H